@@ -77,6 +77,7 @@ namespace pm {
 		bool storeConvergence, storeOccRatio;
 		std::vector<ConvergenceData> convergence;
         bool occDist;
+		bool verbose; // iteration prints
 
 		NNSettings() : mask(), completeness(), convergence() {
 			patchSize = 7;
@@ -105,6 +106,7 @@ namespace pm {
 			storeConvergence = false;
             storeOccRatio = false;
             occDist = false;
+			verbose = false;
 		}
 	};
 
@@ -162,7 +164,8 @@ namespace pm {
 			field->initJumpBuffer(settings.jumpBufferSize, settings.jumpSigmaRatio);
 		}
 
-		std::cout << "NNF: " << field->height << " x " << field->width << "\n";
+		if (settings.verbose)
+			std::cout << "NNF: " << field->height << " x " << field->width << "\n";
 		// real window size
 		if (settings.windowSize <= 0) {
 			settings.windowSize = std::max(target->cols, target->rows);
@@ -391,17 +394,19 @@ namespace pm {
 				cv.cohRatio = cohRatio;
 				cv.occRatio = occRatio;
 			}
-			std::cout << (i + 1) << ". iteration completed [p=" << propCount;
-			std::cout << ", rs=" << rsCount << ", sc=" << simCount;
-			std::cout << ", as=" << asCount << ", ic=" << isCount << "]";
-			if(settings.incompleteSearch > 0){
-				int vsc, tsc, sjc, src;
-				field->getSampleCount(vsc, tsc, sjc, src);
-				std::cout << "{samp " << int(vsc * 100.0f / tsc) << "%, jump ";
-				std::cout << int(sjc * 100.0f / vsc) << "%, reset " << src << "}";
+			if (settings.verbose) {
+				std::cout << (i + 1) << ". iteration completed [p=" << propCount;
+				std::cout << ", rs=" << rsCount << ", sc=" << simCount;
+				std::cout << ", as=" << asCount << ", ic=" << isCount << "]";
+				if(settings.incompleteSearch > 0){
+					int vsc, tsc, sjc, src;
+					field->getSampleCount(vsc, tsc, sjc, src);
+					std::cout << "{samp " << int(vsc * 100.0f / tsc) << "%, jump ";
+					std::cout << int(sjc * 100.0f / vsc) << "%, reset " << src << "}";
+				}
+				std::cout << "(maxDist=" << maxD << ", meanDist=" << meanD;
+				std::cout << ", coh=" << cohRatio << ", occRatio=" << occRatio << ").\n";
 			}
-			std::cout << "(maxDist=" << maxD << ", meanDist=" << meanD;
-			std::cout << ", coh=" << cohRatio << ", occRatio=" << occRatio << ").\n";
 			if (!std::isfinite(maxD) || !std::isfinite(meanD)) {
 				for (int y = 0; y < field->height; ++y) {
 					for (int x = 0; x < field->width; ++x) {
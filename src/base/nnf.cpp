@@ -148,6 +148,7 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
             settings.occDist = mxCheckedScalar(tmp, "Invalid completeness distance boolean.") != 0;
         settings.storeOccRatio = mxBoolField(options, 0, "saveOccRatio", false);
 		settings.completePropagation = mxBoolField(options, 0, "comp_prop", false);
+		settings.verbose = mxBoolField(options, 0, "verbose", false);
 		
 		// --- incomplete search -----------------------------------------------
 		if((settings.incompleteSearch = mxScalarField(options, 0, "incomp_search")) > 0) {
@@ -14,6 +14,8 @@
 #include <rng.h>
 #include <voting/histogram.h>
 #include <voting/meanshift.h>
+#include <voting/median.h>
+#include <voting/scatter.h>
 
 namespace pm {
 
@@ -385,6 +387,11 @@ namespace pm {
 	 * \brief Vote by using a simple filter over overlapping patches
 	 * and a tiled strategy with openmp
 	 * 
+	 * Each tile of patches accumulates into its own halo buffer
+	 * (tile + patch width - 1 pixels wide), which is then added to the vote.
+	 * Tiles are processed in four phases (by parity of their tile row and
+	 * column) so that the halos merged concurrently never overlap.
+	 * 
 	 * \param nnf
 	 *			the nearest neighbor field to vote with
 	 * \param params
@@ -413,45 +420,22 @@ namespace pm {
 			}
 		}
 		const Filter &filter = params.filter;
-#if _OPENMP
-#pragma omp parallel
-#endif
-		{
-			int tid = omp_get_thread_num(), nt = omp_get_num_threads();
-			int patchY = std::ceil(float(h) / Patch::width());
-			int patchX = std::ceil(float(w) / Patch::width());
-			int tiles = patchY * patchX;
-			int minTile = tiles * tid / nt;
-			int maxTile = tiles * (tid + 1) / nt;
-			// for each tile
-			for (int tile = minTile; tile < maxTile; ++tile) {
-				// for each patch (pixel) of the corresponding tile
-				int x = (tile % patchX) * Patch::width();
-				int nX = std::min(x + Patch::width(), w);
-				for (; x < nX; ++x) {
-					int y = (tile / patchX) * Patch::width();
-					int nY = std::min(y + Patch::width(), h);
-					for (; y < nY; ++y) {
-						// /!\ This ^ was done over the nnf field that is smaller than the source!
-						const Patch &patch = nnf->get(y, x);
-						// for each pixel in the corresponding patch
-						for (int px = 0; px < Patch::width(); ++px) {
-							for (int py = 0; py < Patch::width(); ++py) {
-								// /!\ <-- this is done over the source (nff + patch size)
-								PixVal value = target->at<PixVal>(patch.transform(py, px));
-								vote.at<PixVal>(y + py, x + px) += value * filter[py][px];
-								weights[sw * (y + py) + x + px] += filter[py][px];
-							}
-						}
-					}
-				}
-			}
-		}
+		const int P = Patch::width();
+		// tiles of patches (at least P - 1 wide, see voting::tiledScatter)
+		voting::tiledScatter<PixVal>(h, w, P, std::max(32, P), sh, sw,
+			[&](int y, int x, int py, int px, PixVal &value) {
+				// /!\ (y, x) is over the nnf field that is smaller than the source!
+				value = target->at<PixVal>(nnf->get(y, x).transform(py, px));
+				return float(filter[py][px]);
+			},
+			[&](int y, int x, const PixVal &value, float weight) {
+				vote.at<PixVal>(y, x) += value;
+				weights[sw * y + x] += weight;
+			});
 
-		std::cout << ". normalizing\n";
 		// normalization of the pixel values
 #if _OPENMP
-#pragma omp for collapse(2)
+#pragma omp parallel for
 #endif
 		for (int y = 0; y < sh; ++y) {
 			for (int x = 0; x < sw; ++x) {
@@ -539,20 +523,24 @@ namespace pm {
 		return vote;
 	}
 	
+#ifndef MEDIAN_CAPACITY
+#define MEDIAN_CAPACITY 81
+#endif
+
 	template <int K, typename Scalar>
 	class MedianList{
 	public:
 		typedef float Weight;
 		typedef std::pair<Scalar, Weight> Item;
-		struct ItemOrder {
-			bool operator()(const Item &left, const Item &right) {
-				return left.first < right.first;
-			}
-		};
 		typedef Vec<Scalar, K> Value;
-		typedef Vec<float, K> WeightVec;
 		MedianList(int N) : count(0), total(0.0f) {
-			for(int k = 0; k < K; ++k) lists[k].resize(N); // allocate space
+			// fixed storage on the stack, unless the patches are too large
+			if(N > MEDIAN_CAPACITY) {
+				extra.resize(K * N);
+				for(int k = 0; k < K; ++k) lists[k] = &extra[k * N];
+			} else {
+				for(int k = 0; k < K; ++k) lists[k] = buffer[k];
+			}
 		}
 		inline void push(const Value &v, Weight w) {
 			for(int k = 0; k < K; ++k){
@@ -561,33 +549,23 @@ namespace pm {
 			++count;
 			total += w;
 		}
-		inline void sort() {
-			for(int k = 0; k < K; ++k) std::sort(lists[k].begin(), lists[k].end(), ItemOrder());
-		}
-		inline Value get() const {
+		inline Value get() {
 			const Weight middle = total * 0.5f; // varies with the position (since boundary patches have smaller weights)
 			Value val; // value computation
-			WeightVec weight = WeightVec::zeros(); // weight storage
-			for(int i = 0; i < count; ++i) {
-				// separately for each channel
-				bool more = false;
-				for(int k = 0; k < K; ++k) {
-					const Item &it = lists[k][i];
-					if(weight[k] < middle){
-						weight[k] += it.second;
-						// if we went past the center, that's the median
-						if(weight[k] >= middle) val[k] = it.first;
-						else more = true; // else we need to go farther
-					} // else nothing more
-				}
-				if(!more) break;
+			for(int k = 0; k < K; ++k) {
+				val[k] = voting::weightedSelect(lists[k], count, middle);
 			}
 			return val;
 		}
 	private:
+		MedianList(const MedianList &); // lists may point to the buffer
+		MedianList &operator =(const MedianList &);
+
 		int count;
 		Weight total;
-		std::vector<Item> lists[K];
+		Item *lists[K];
+		Item buffer[K][MEDIAN_CAPACITY];
+		std::vector<Item> extra;
 	};
 	
 	template <int channels, typename Patch, typename Scalar>
@@ -628,9 +606,7 @@ namespace pm {
 						points.push(target->at<PixVal>(patch.transform(by, bx)), params.filter[by][bx]);
 					}
 				}
-				// sort data, channel by channel
-				points.sort();
-				// get the sort-of median
+				// get the sort-of median, channel by channel
 				vote.at<PixVal>(y, x) = points.get();
 				
 				switch(params.weightType) {
@@ -927,25 +903,45 @@ namespace pm {
 		}
 		
 		// process the reverse nnf first
-		for (int y = 0; y < revNNF.height; ++y) {
-			for(int x = 0; x < revNNF.width; ++x) {
-				SourcePatch p(y, x);
-				const TargetPatch &q = revNNF.get(y, x);
-				// for each pixel from the patch p in S
-				for (typename SourcePatch::IndexIterator it = p.begin(); it; ++it) {
-					typename SourcePatch::Index i = *it;
-					const Point2i lp(p.transform(i));
-					PixVal pix = S->at<PixVal>(lp); // transformation in S space
-					// target in T
-					const Point2i lq(q * i); // q.transform(i)
-					const Point2i delta = lp - Point2i(x, y); // (x,y) is at the top-left of the patch
-					float w = filter[delta.y][delta.x] * revWeight;
-					vote.at<PixVal>(lq.y, lq.x) += pix * w;
-					// store weight (count for Ns when filter = 1)
-					weights[vote.cols * lq.y + lq.x] += w;
-				}
+		// => its patches scatter into T, in parallel bands of rows at least
+		//    as high as any footprint (see voting::bandScatter)
+		const int numRev = revNNF.height * revNNF.width;
+		std::vector<int> revTop(numRev);
+		int footprint = 1;
+#if _OPENMP
+#pragma omp parallel for reduction(max:footprint)
+#endif
+		for (int n = 0; n < numRev; ++n) {
+			const int y = n / revNNF.width, x = n % revNNF.width;
+			SourcePatch p(y, x);
+			const TargetPatch &q = revNNF.get(y, x);
+			int minY = T->rows, maxY = -1;
+			for (typename SourcePatch::IndexIterator it = p.begin(); it; ++it) {
+				const Point2i lq(q * (*it));
+				minY = std::min(minY, lq.y);
+				maxY = std::max(maxY, lq.y);
 			}
+			revTop[n] = minY;
+			footprint = std::max(footprint, maxY - minY + 1);
 		}
+		voting::bandScatter(revTop, footprint, T->rows, [&](int n) {
+			const int y = n / revNNF.width, x = n % revNNF.width;
+			SourcePatch p(y, x);
+			const TargetPatch &q = revNNF.get(y, x);
+			// for each pixel from the patch p in S
+			for (typename SourcePatch::IndexIterator it = p.begin(); it; ++it) {
+				typename SourcePatch::Index i = *it;
+				const Point2i lp(p.transform(i));
+				PixVal pix = S->at<PixVal>(lp); // transformation in S space
+				// target in T
+				const Point2i lq(q * i); // q.transform(i)
+				const Point2i delta = lp - Point2i(x, y); // (x,y) is at the top-left of the patch
+				float w = filter[delta.y][delta.x] * revWeight;
+				vote.at<PixVal>(lq.y, lq.x) += pix * w;
+				// store weight (count for Ns when filter = 1)
+				weights[vote.cols * lq.y + lq.x] += w;
+			}
+		});
 		
 		// process the direct nnf finally
 #if _OPENMP
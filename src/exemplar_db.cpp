@@ -0,0 +1,123 @@
+/*
+ * File:   exemplar_db.cpp
+ */
+
+#define USE_MATLAB 1
+
+#include "math/imageset.h"
+#include "matlab.h"
+#include "matlab/database.h"
+
+#include <map>
+
+using namespace pm;
+
+namespace {
+
+    //! live databases by id (the mex file stays locked while there is any)
+    std::map<uint64_t, ExemplarDB *> databases;
+    uint64_t lastId = 0;
+
+    void release(uint64_t id) {
+        auto it = databases.find(id);
+        delete it->second;
+        databases.erase(it);
+        if(databases.empty() && mexIsLocked()){
+            mexUnlock();
+        }
+    }
+
+    void releaseAll() {
+        while(!databases.empty()){
+            release(databases.begin()->first);
+        }
+    }
+
+    uint64_t liveId(const mxArray *arr) {
+        uint64_t id = mxHandleValue(arr);
+        if(databases.find(id) == databases.end()){
+            mexErrMsgIdAndTxt("MATLAB:ixdb:invalidHandle", "Unknown or released database handle.");
+        }
+        return id;
+    }
+
+}
+
+/**
+ * Usage:
+ *
+ * db = ixdb('load', {lefts}, {rights}, {uvs}, {descriptors})
+ * ixdb('free', db)
+ * ixdb('clear')
+ * ptr = ixdb('get', db)
+ *
+ * where all but the left images are optional (or empty).
+ * The handle db can then be used in place of the image cells of
+ * ixknnf, ixknnf_top and ixvote, with options.db_set selecting which
+ * images to use ('left' by default, 'right' for ixvote).
+ *
+ * The handle is an id, which is never reused. The 'get' command is used by
+ * the other mex functions to validate it: it returns the address of the
+ * database, and fails for unknown or released ids.
+ */
+void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
+    // checking the input
+	if (nin < 1 || !mxIsChar(in[0])) {
+		mexErrMsgIdAndTxt("MATLAB:ixdb:invalidInputs",
+				"Requires a command: 'load', 'free', 'clear' or 'get'.");
+	}
+	// checking the output
+	if (nout > 1) {
+		mexErrMsgIdAndTxt("MATLAB:ixdb:maxlhs",
+				"Too many output arguments.");
+	}
+
+    if(mxStringEquals(in[0], "load")){
+        if(nin < 2 || nin > 1 + DB_NUM_SETS){
+            mexErrMsgIdAndTxt("MATLAB:ixdb:invalidNumInputs",
+                    "Requires between 1 and %d image sets! (#in = %d)", DB_NUM_SETS, nin - 1);
+        }
+        // loaded into a local, and only allocated once valid: an error never
+        // leaves a heap database behind (the images are freed when it unwinds)
+        ExemplarDB loaded;
+        for(int s = 0; s + 1 < nin; ++s){
+            if(mxGetNumberOfElements(in[s + 1]) > 0){
+                // copies, since the arrays may be released after this call
+                loaded.sets[s] = mxArrayToImageSet(in[s + 1], "Invalid database image", false);
+            }
+        }
+        if(loaded.sets[DB_LEFT].size() == 0){
+            mexErrMsgIdAndTxt("MATLAB:ixdb:noImage", "The database requires left images.");
+        }
+        for(int s = 1; s < DB_NUM_SETS; ++s){
+            if(loaded.sets[s].size() > 0 && loaded.sets[s].size() != loaded.sets[DB_LEFT].size()){
+                mexErrMsgIdAndTxt("MATLAB:ixdb:invalidSet", "The %s images do not match the left ones.", exemplarSetName(s));
+            }
+        }
+        if(databases.empty()){
+            mexLock();
+            mexAtExit(releaseAll);
+        }
+        // the images are shared with the local copy
+        databases[++lastId] = new ExemplarDB(loaded);
+        out[0] = mxCreateHandle(lastId);
+
+    } else if(mxStringEquals(in[0], "free")){
+        if(nin != 2){
+            mexErrMsgIdAndTxt("MATLAB:ixdb:invalidNumInputs", "Requires a database handle.");
+        }
+        release(liveId(in[1]));
+
+    } else if(mxStringEquals(in[0], "clear")){
+        releaseAll();
+
+    } else if(mxStringEquals(in[0], "get")){
+        if(nin != 2){
+            mexErrMsgIdAndTxt("MATLAB:ixdb:invalidNumInputs", "Requires a database handle.");
+        }
+        out[0] = mxCreateHandle(reinterpret_cast<uintptr_t>(databases[liveId(in[1])]));
+
+    } else {
+        mexErrMsgIdAndTxt("MATLAB:ixdb:invalidCommand", "Unknown command (load, free, clear or get).");
+    }
+}
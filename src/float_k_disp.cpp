@@ -12,6 +12,7 @@
 #endif
 
 #include "impl/k_disp.h"
+#include "io/telemetry.h"
 #include "nnf/algorithm.h"
 #include "nnf/horizontalsearch.h"
 #include "nnf/horizontalrandsearch.h"
@@ -31,6 +32,16 @@ typedef Distance<Patch2tf, float, BilinearMatF> DistanceFunc;
  * Usage:
  * 
  * [newNNF, conv] = fkdisp( left, right, prevNNF, options )
+ *
+ * conv has one row per search step and one column per iteration, with the
+ * number of successful updates. When built with PM_STEP_STATS (make STATS=1),
+ * it is followed by blocks of rows (one per step) with the time in
+ * microseconds, the distance evaluations, the filtered candidates and the
+ * duplicate candidates.
+ *
+ * With options.telemetry = 'path', the convergence of each iteration is
+ * appended to the file (options.telemetry_format = 'json' lines or 'csv').
+ * A warning is raised if the file cannot be written.
  */
 void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // checking the input
@@ -84,36 +95,40 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
                            << LocalMean<Patch2tf, float, KNNF_K, 16>(&nnf);
     NoOp<Point2i, bool, false> filter;
     DecreasingSearchRadius<float> post(&search);
-    
-    std::cout << "init.\n";
+    const std::string telemetryPath = options.string("telemetry", "");
+    TelemetryPtr sink = createTelemetry(telemetryPath, options.string("telemetry_format", "json"));
+    if(!telemetryPath.empty() && !sink){
+        mexWarnMsgIdAndTxt("MATLAB:nnf:telemetry", "Cannot write the telemetry to %s, it is disabled.", telemetryPath.c_str());
+    }
+    TelemetryIteration<NNF> telemetry(sink.get(), "fkdisp", &nnf);
     
     // scanline with the sequence of algorithm
     if(nout > 1){
         VerboseAlgorithm vseq(seq);
         ConvergenceDiary::Data convData;
-        auto pseq = PostSequence() << post << ConvergenceDiary(&vseq, &convData);
-        
-        scanline(nnf, numIter, vseq, filter, pseq);
+        auto pseq = PostSequence() << post << ConvergenceDiary(&vseq, &convData) << std::ref(telemetry);
+        auto counted = telemetry.count(vseq);
         
-        std::cout << "post scanline.\n";
+        scanline(nnf, numIter, counted, filter, pseq);
         
         MatXD convMat(convData.size(), numIter, IM_64FC(1));
         for(int algo = 0; algo < convData.size(); ++algo){
             for(int iter = 0; iter < numIter; ++iter){
-                convMat.update<double>(algo, iter, convData[algo][iter]);
+                // the scanline may stop before numIter
+                double v = iter < convData[algo].size() ? convData[algo][iter] : 0.0;
+                convMat.update<double>(algo, iter, v);
             }
         }
         out[1] = convMat;
     } else {
-        scanline(nnf, numIter, seq, filter, post);
-        std::cout << "post scanline2.\n";
+        auto pseq = PostSequence() << post << std::ref(telemetry);
+        auto counted = telemetry.count(seq);
+        scanline(nnf, numIter, counted, filter, pseq);
     }
     
     // save nnf and output it
     if(nout > 0){
         out[0] = nnf.save();
     }
-    
-    std::cout << "done.\n";
 }
 
@@ -31,15 +31,17 @@ namespace pm {
         
         Image compute() const{
             PixelContainer<channels, Patch2tf, float, KNNF_K> data(nnf);
-            return disparity_vote(data, *filter, *nnf, prctile);
+            return disparity_vote(data, *filter, *nnf, prctile, sigma2, quiet);
         }
 
-        VoteOperation(const VoteOperation<channels-1> &v) :  nnf(v.nnf), filter(v.filter), prctile(v.prctile) {}
-        VoteOperation(NNF *n, Filter *f, float p) : nnf(n), filter(f), prctile(p) {}
+        VoteOperation(const VoteOperation<channels-1> &v) :  nnf(v.nnf), filter(v.filter), prctile(v.prctile), sigma2(v.sigma2), quiet(v.quiet) {}
+        VoteOperation(NNF *n, Filter *f, float p, float s, bool q) : nnf(n), filter(f), prctile(p), sigma2(s), quiet(q) {}
 
         NNF *nnf;
         Filter *filter;
         float prctile;
+        float sigma2;
+        bool quiet;
     };
 
 }
@@ -48,6 +50,9 @@ namespace pm {
  * Usage:
  * 
  * uv = fkdisp_vote( source, target, knnf, options )
+ *
+ * with options.knn_sigma2 > 0 to vote with all the k entries,
+ * and options.quiet to skip the disparity percentiles report
  */
 void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // checking the input
@@ -91,7 +96,9 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     }
     
     // vote result
-    VoteOperation<1> op(&nnf, &filter, options.scalar<float>("disp_prctile", 0.975));
+    // k-nn vote weighted by the patch distances if knn_sigma2 > 0
+    VoteOperation<1> op(&nnf, &filter, options.scalar<float>("disp_prctile", 0.975), options.scalar<float>("knn_sigma2", 0.0f),
+        options.boolean("quiet", false));
     Image img = vote(op, source.channels());
     if(nout > 0){
         out[0] = mxImageToArray(img);
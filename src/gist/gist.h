@@ -0,0 +1,283 @@
+/*
+ * File:   gist.h
+ */
+
+#ifndef GIST_H
+#define	GIST_H
+
+#include "../image/resize.h"
+#include "../math/fft.h"
+#include "../math/mat.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace pm {
+
+    /**
+     * Gist parameters (defaults of toolbox/imgist.m)
+     */
+    struct GistParams {
+        int imageSize;
+        int numberBlocks;
+        float fcPrefilt;
+        int boundaryExtension;
+        std::vector<int> orientationsPerScale;
+
+        GistParams() : imageSize(256), numberBlocks(4), fcPrefilt(4.0f), boundaryExtension(32),
+                       orientationsPerScale(4, 8) {}
+
+        inline int filters() const {
+            int n = 0;
+            for(int o : orientationsPerScale) n += o;
+            return n;
+        }
+        //! number of features per channel
+        inline int features() const {
+            return filters() * numberBlocks * numberBlocks;
+        }
+    };
+
+    namespace gist {
+
+        //! symmetric padding index (as padarray with 'symmetric')
+        inline int mirror(int i, int n) {
+            while(i < 0 || i >= n){
+                i = i < 0 ? -i - 1 : 2 * n - i - 1;
+            }
+            return i;
+        }
+
+        //! signed frequency of an fft index (equivalent of fftshift on a centered grid)
+        inline float frequency(int i, int n) {
+            return i < n / 2 ? float(i) : float(i - n);
+        }
+
+        //! load a single channel into a padded complex buffer
+        inline void pad(const std::vector<float> &plane, int size, int margin, int padded, std::vector<Complex> &out) {
+            out.resize(padded * padded);
+            for(int y = 0; y < padded; ++y){
+                const float *row = &plane[mirror(y - margin, size) * size];
+                for(int x = 0; x < padded; ++x){
+                    out[y * padded + x] = Complex(row[mirror(x - margin, size)], 0.0f);
+                }
+            }
+        }
+
+    }
+
+    /**
+     * \brief Gist descriptor extractor (Oliva & Torralba)
+     *
+     * Native version of libs/gist/LMgist.m as called by toolbox/imgist.m:
+     * each channel gets its own descriptor, and the output is laid out as
+     * g(:) of the [channels x features] Matlab matrix.
+     *
+     * The Gabor transfer functions and the prefiltering gaussian are
+     * precomputed once in the constructor (for the given image size) and the
+     * extractor is then read-only, so that it can be shared by threads.
+     */
+    class GistExtractor {
+    public:
+
+        explicit GistExtractor(const GistParams &p = GistParams())
+        : params(p),
+          prefiltMargin(5),
+          prefiltSize(p.imageSize + 10 + (p.imageSize % 2)),
+          gaborSize(p.imageSize + 2 * p.boundaryExtension),
+          prefiltFwd(prefiltSize, prefiltSize), prefiltInv(prefiltSize, prefiltSize, true),
+          gaborFwd(gaborSize, gaborSize), gaborInv(gaborSize, gaborSize, true) {
+            createPrefilter();
+            createGabor();
+        }
+
+        //! descriptor size for an image with a given number of channels
+        inline int dimension(int channels) const {
+            return channels * params.features();
+        }
+
+        inline const GistParams &parameters() const {
+            return params;
+        }
+
+        /**
+         * \brief Compute the gist descriptor of a float image
+         *
+         * \param img
+         *          the image (IM_32FC(n), any size)
+         * \param out
+         *          the output descriptor (dimension(n) floats)
+         */
+        void compute(const Image &img, float *out) const {
+            const int S = params.imageSize;
+            const int C = img.channels();
+            const int F = params.features();
+            Image square = resizeCrop(img, S);
+            std::vector<float> plane(S * S);
+            std::vector<float> g(F);
+            for(int c = 0; c < C; ++c){
+                // extract channel and scale its intensities to [0;255]
+                float minVal = std::numeric_limits<float>::max(), maxVal = -minVal;
+                for(int y = 0; y < S; ++y){
+                    for(int x = 0; x < S; ++x){
+                        float v = square.ptr<float>(y, x)[c];
+                        plane[y * S + x] = v;
+                        minVal = std::min(minVal, v);
+                        maxVal = std::max(maxVal, v);
+                    }
+                }
+                const float range = maxVal - minVal;
+                const float factor = range > 0.0f ? 255.0f / range : 0.0f;
+                for(float &v : plane){
+                    v = (v - minVal) * factor;
+                }
+                prefilter(plane);
+                gabor(plane, &g[0]);
+                // g(:) of [C x F]
+                for(int f = 0; f < F; ++f){
+                    out[f * C + c] = g[f];
+                }
+            }
+        }
+
+        std::vector<float> compute(const Image &img) const {
+            std::vector<float> g(dimension(img.channels()));
+            compute(img, &g[0]);
+            return g;
+        }
+
+    private:
+
+        void createPrefilter() {
+            const int n = prefiltSize;
+            const float s1 = params.fcPrefilt / std::sqrt(std::log(2.0f));
+            gf.resize(n * n);
+            for(int y = 0; y < n; ++y){
+                float fy = gist::frequency(y, n);
+                for(int x = 0; x < n; ++x){
+                    float fx = gist::frequency(x, n);
+                    gf[y * n + x] = std::exp(-(fx * fx + fy * fy) / (s1 * s1));
+                }
+            }
+        }
+
+        void createGabor() {
+            const int n = gaborSize;
+            const int N = params.filters();
+            std::vector<float> fr(n * n), t(n * n);
+            for(int y = 0; y < n; ++y){
+                float fy = gist::frequency(y, n);
+                for(int x = 0; x < n; ++x){
+                    float fx = gist::frequency(x, n);
+                    fr[y * n + x] = std::sqrt(fx * fx + fy * fy);
+                    t[y * n + x] = std::atan2(fy, fx);
+                }
+            }
+            G.resize(size_t(N) * n * n);
+            int l = 0;
+            for(int i = 0, S = params.orientationsPerScale.size(); i < S; ++i){
+                const int o = params.orientationsPerScale[i];
+                for(int j = 0; j < o; ++j, ++l){
+                    const float p0 = 0.35f;
+                    const float p1 = 0.3f / std::pow(1.85f, float(i));
+                    const float p2 = 16.0f * o * o / (32.0f * 32.0f);
+                    const float p3 = float(M_PI) / o * j;
+                    float *g = &G[size_t(l) * n * n];
+                    for(int k = 0; k < n * n; ++k){
+                        float tr = t[k] + p3;
+                        if(tr < -M_PI) tr += 2.0f * M_PI;
+                        else if(tr > M_PI) tr -= 2.0f * M_PI;
+                        float r = fr[k] / n / p1 - 1.0f;
+                        g[k] = std::exp(-10.0f * p0 * r * r - 2.0f * p2 * float(M_PI) * tr * tr);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Local contrast normalization (prefilt in LMgist.m)
+         */
+        void prefilter(std::vector<float> &plane) const {
+            const int S = params.imageSize, n = prefiltSize, w = prefiltMargin;
+            std::vector<float> logPlane(plane.size());
+            for(size_t i = 0; i < plane.size(); ++i){
+                logPlane[i] = std::log(plane[i] + 1.0f);
+            }
+            // whitening
+            std::vector<Complex> buf;
+            gist::pad(logPlane, S, w, n, buf);
+            std::vector<float> output(n * n);
+            for(int i = 0; i < n * n; ++i) output[i] = buf[i].real();
+            prefiltFwd(&buf[0]);
+            for(int i = 0; i < n * n; ++i) buf[i] *= gf[i];
+            prefiltInv(&buf[0]);
+            for(int i = 0; i < n * n; ++i){
+                output[i] -= buf[i].real();
+                buf[i] = Complex(output[i] * output[i], 0.0f);
+            }
+            // local contrast normalization
+            prefiltFwd(&buf[0]);
+            for(int i = 0; i < n * n; ++i) buf[i] *= gf[i];
+            prefiltInv(&buf[0]);
+            for(int y = 0; y < S; ++y){
+                for(int x = 0; x < S; ++x){
+                    int i = (y + w) * n + x + w;
+                    float localstd = std::sqrt(std::abs(buf[i]));
+                    plane[y * S + x] = output[i] / (0.2f + localstd);
+                }
+            }
+        }
+
+        /**
+         * Gabor filter energies averaged over blocks (gistGabor in LMgist.m)
+         */
+        void gabor(const std::vector<float> &plane, float *g) const {
+            const int S = params.imageSize, n = gaborSize, be = params.boundaryExtension;
+            const int w = params.numberBlocks, W = w * w;
+            std::vector<Complex> img, buf(n * n);
+            gist::pad(plane, S, be, n, img);
+            gaborFwd(&img[0]);
+            // block boundaries (fix(linspace(0, S, w+1)))
+            std::vector<int> bounds(w + 1);
+            for(int b = 0; b <= w; ++b) bounds[b] = (b * S) / w;
+            std::vector<float> energy(S * S);
+            for(int f = 0, N = params.filters(); f < N; ++f){
+                const float *Gf = &G[size_t(f) * n * n];
+                for(int i = 0; i < n * n; ++i) buf[i] = img[i] * Gf[i];
+                gaborInv(&buf[0]);
+                for(int y = 0; y < S; ++y){
+                    for(int x = 0; x < S; ++x){
+                        energy[y * S + x] = std::abs(buf[(y + be) * n + x + be]);
+                    }
+                }
+                // average over non-overlapping blocks (column-major block order)
+                for(int bx = 0; bx < w; ++bx){
+                    for(int by = 0; by < w; ++by){
+                        double sum = 0.0;
+                        for(int y = bounds[by]; y < bounds[by + 1]; ++y){
+                            for(int x = bounds[bx]; x < bounds[bx + 1]; ++x){
+                                sum += energy[y * S + x];
+                            }
+                        }
+                        int count = (bounds[by + 1] - bounds[by]) * (bounds[bx + 1] - bounds[bx]);
+                        g[f * W + by + bx * w] = count > 0 ? sum / count : 0.0f;
+                    }
+                }
+            }
+        }
+
+        GistParams params;
+        int prefiltMargin;
+        int prefiltSize;
+        int gaborSize;
+        FFT2D prefiltFwd, prefiltInv;
+        FFT2D gaborFwd, gaborInv;
+        std::vector<float> gf;
+        std::vector<float> G;
+    };
+
+}
+
+#endif	/* GIST_H */
+
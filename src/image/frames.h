@@ -0,0 +1,44 @@
+/*
+ * File:   frames.h
+ */
+
+#ifndef IMAGE_FRAMES_H
+#define	IMAGE_FRAMES_H
+
+#include "resize.h"
+#include "../math/mat.h"
+
+namespace pm {
+
+    /**
+     * \brief Split a stereo exemplar (left on top of right) into its frames
+     *
+     * @see toolbox/get_frames.m
+     */
+    inline void splitFrames(const Image &img, Image *left, Image *right) {
+        const int h0 = img.rows / 2;           // floor(h/2)
+        const int h1 = (img.rows + 1) / 2;     // ceil(h/2)
+        if(left){
+            *left = crop(img, 0, 0, h0, img.cols);
+        }
+        if(right){
+            *right = crop(img, h1, 0, img.rows - h1, img.cols);
+        }
+    }
+
+    inline Image leftFrame(const Image &img) {
+        Image left;
+        splitFrames(img, &left, NULL);
+        return left;
+    }
+
+    inline Image rightFrame(const Image &img) {
+        Image right;
+        splitFrames(img, NULL, &right);
+        return right;
+    }
+
+}
+
+#endif	/* IMAGE_FRAMES_H */
+
@@ -0,0 +1,293 @@
+/*
+ * File:   pyramid.h
+ */
+
+#ifndef IMAGE_PYRAMID_H
+#define	IMAGE_PYRAMID_H
+
+#include "../math/mat.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+namespace pm {
+
+    namespace pyramid {
+
+        //! 1d generating kernel of toolbox/pyr_kernel.m (a = 0.4)
+        static const float kernel[5] = { 0.05f, 0.25f, 0.4f, 0.25f, 0.05f };
+
+        /**
+         * \brief Weighted sum of up to 5 rows: out = sum_i w[i] * rows[i]
+         *
+         * This is the vertical pass of the separable filters, it works on full
+         * contiguous rows (all channels interleaved) and is where most of the
+         * time is spent, hence the explicit SIMD version.
+         */
+        inline void combineRows(float *out, const float * const *rows, const float *w, int n, int len) {
+            int i = 0;
+#ifdef __SSE__
+            for(; i + 4 <= len; i += 4){
+                __m128 sum = _mm_mul_ps(_mm_set1_ps(w[0]), _mm_loadu_ps(rows[0] + i));
+                for(int r = 1; r < n; ++r){
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[r]), _mm_loadu_ps(rows[r] + i)));
+                }
+                _mm_storeu_ps(out + i, sum);
+            }
+#endif
+            for(; i < len; ++i){
+                float sum = w[0] * rows[0][i];
+                for(int r = 1; r < n; ++r){
+                    sum += w[r] * rows[r][i];
+                }
+                out[i] = sum;
+            }
+        }
+
+        inline const float *row(const Image &img, int y) {
+            return img.ptr<float>(y, 0);
+        }
+        inline float *row(Image &img, int y) {
+            return img.ptr<float>(y, 0);
+        }
+
+    }
+
+    /**
+     * \brief Number of pyramid reductions for an image (toolbox/pyr_levels.m)
+     *
+     * The coarsest scale has a minimum dimension of at least 16.
+     */
+    inline int pyramidLevels(int rows, int cols) {
+        int side = std::min(rows, cols), log2 = -1;
+        while(side > 0){
+            side >>= 1;
+            ++log2;
+        }
+        return std::max(0, log2 - 4);
+    }
+
+    /**
+     * \brief Blur and subsample an image by a factor of 2 (toolbox/pyr_reduce.m)
+     *
+     * Borders are zero-padded as with imfilter(..., 'conv').
+     *
+     * \param img
+     *          a float image (IM_32FC(n)) of size r x c
+     * \return the reduced image of size ceil(r/2) x ceil(c/2)
+     */
+    inline Image pyrReduce(const Image &img) {
+        assert(img.depth() == IM_32F && "Pyramids only support float images");
+        const int C = img.channels();
+        const int rows = (img.rows + 1) / 2, cols = (img.cols + 1) / 2;
+        const int len = img.cols * C;
+        Image out(rows, cols, img.type());
+#pragma omp parallel
+        {
+            std::vector<float> tmp(len);
+            const float *src[5];
+            float w[5];
+#pragma omp for
+            for(int y = 0; y < rows; ++y){
+                // vertical pass on the rows 2y-2 .. 2y+2
+                int n = 0;
+                for(int j = 0; j < 5; ++j){
+                    int sy = 2 * y + j - 2;
+                    if(sy >= 0 && sy < img.rows){
+                        src[n] = pyramid::row(img, sy);
+                        w[n++] = pyramid::kernel[j];
+                    }
+                }
+                pyramid::combineRows(&tmp[0], src, w, n, len);
+                // horizontal pass at even columns only
+                float *dst = pyramid::row(out, y);
+                for(int x = 0; x < cols; ++x){
+                    const int x0 = std::max(0, 2 * x - 2), x1 = std::min(img.cols - 1, 2 * x + 2);
+                    for(int c = 0; c < C; ++c){
+                        float sum = 0.0f;
+                        for(int sx = x0; sx <= x1; ++sx){
+                            sum += pyramid::kernel[sx - 2 * x + 2] * tmp[sx * C + c];
+                        }
+                        dst[x * C + c] = sum;
+                    }
+                }
+            }
+        }
+        return out;
+    }
+
+    /**
+     * \brief Upsample and blur an image, adding the result to another one
+     *
+     * Computes dst += weight * pyr_expand(src, size(dst)), without allocating
+     * the intermediate full-size image (@see toolbox/pyr_expand.m).
+     *
+     * \param src
+     *          the coarse image (r x c)
+     * \param dst
+     *          the fine image (at most 2r x 2c) to accumulate into
+     * \param weight
+     *          the weight of the expanded image (-1 for a laplacian band)
+     */
+    inline void pyrExpandAdd(const Image &src, Image &dst, float weight = 1.0f) {
+        assert(src.depth() == IM_32F && dst.type() == src.type() && "Invalid pyramid images");
+        assert(dst.rows <= 2 * src.rows && dst.cols <= 2 * src.cols && "Expanding beyond twice the size");
+        const int C = src.channels();
+        const int len = src.cols * C;
+        // the factor 4 of pyr_expand is split between both passes
+        const float *k = pyramid::kernel;
+        const float evenW[3] = { 2.0f * k[0], 2.0f * k[2], 2.0f * k[4] }; // rows i+1, i, i-1
+        const float oddW[2] = { 2.0f * k[1], 2.0f * k[3] };               // rows i+1, i
+        const float hk[5] = { 2.0f * weight * k[0], 2.0f * weight * k[1], 2.0f * weight * k[2],
+                              2.0f * weight * k[3], 2.0f * weight * k[4] };
+#pragma omp parallel
+        {
+            std::vector<float> tmp(len);
+            const float *rows[3];
+            float w[3];
+#pragma omp for
+            for(int y = 0; y < dst.rows; ++y){
+                // vertical pass (only one row of two gets an input sample)
+                const int i = y / 2;
+                int n = 0;
+                if(y % 2 == 0){
+                    for(int j = 0; j < 3; ++j){
+                        int sy = i + 1 - j;
+                        if(sy >= 0 && sy < src.rows){
+                            rows[n] = pyramid::row(src, sy);
+                            w[n++] = evenW[j];
+                        }
+                    }
+                } else {
+                    for(int j = 0; j < 2; ++j){
+                        int sy = i + 1 - j;
+                        if(sy >= 0 && sy < src.rows){
+                            rows[n] = pyramid::row(src, sy);
+                            w[n++] = oddW[j];
+                        }
+                    }
+                }
+                pyramid::combineRows(&tmp[0], rows, w, n, len);
+                // horizontal pass
+                float *out = pyramid::row(dst, y);
+                for(int x = 0; x < dst.cols; ++x){
+                    const int j = x / 2;
+                    const bool hasNext = j + 1 < src.cols;
+                    const float *t0 = &tmp[j * C], *t1 = t0 + C, *tp = t0 - C;
+                    if(x % 2 == 0){
+                        for(int c = 0; c < C; ++c){
+                            float sum = hk[2] * t0[c];
+                            if(hasNext) sum += hk[0] * t1[c];
+                            if(j > 0)   sum += hk[4] * tp[c];
+                            out[x * C + c] += sum;
+                        }
+                    } else {
+                        for(int c = 0; c < C; ++c){
+                            float sum = hk[3] * t0[c];
+                            if(hasNext) sum += hk[1] * t1[c];
+                            out[x * C + c] += sum;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Upsample and blur an image to a given size (toolbox/pyr_expand.m)
+     */
+    inline Image pyrExpand(const Image &src, int rows, int cols) {
+        Image out = Image::zeros(rows, cols, src.type());
+        pyrExpandAdd(src, out);
+        return out;
+    }
+
+    /**
+     * \brief Gaussian pyramid (toolbox/gaussian_pyr.m)
+     *
+     * \param img
+     *          the finest level
+     * \param levels
+     *          the number of reductions (or -1 for pyramidLevels)
+     * \return levels+1 images from 0=coarsest to levels=finest (shared with img)
+     */
+    inline std::vector<Image> gaussianPyramid(const Image &img, int levels = -1) {
+        if(levels < 0){
+            levels = pyramidLevels(img.rows, img.cols);
+        }
+        std::vector<Image> pyr(levels + 1);
+        pyr[levels] = img;
+        for(int i = levels - 1; i >= 0; --i){
+            pyr[i] = pyrReduce(pyr[i + 1]);
+        }
+        return pyr;
+    }
+
+    /**
+     * \brief Coarsest level of the gaussian pyramid, without keeping the others
+     *
+     * This is also the coarsest level of the laplacian pyramid.
+     */
+    inline Image pyramidTop(const Image &img, int levels) {
+        Image top = img;
+        for(int i = 0; i < levels; ++i){
+            top = pyrReduce(top);
+        }
+        return top;
+    }
+
+    /**
+     * \brief Transform a gaussian pyramid into a laplacian one, in place
+     *
+     * The finest level is replaced by a band-pass copy so that the original
+     * image (shared with pyr.back()) is not modified.
+     *
+     * @see toolbox/laplacian_pyr.m
+     */
+    inline void gaussianToLaplacian(std::vector<Image> &pyr) {
+        for(int i = pyr.size() - 1; i > 0; --i){
+            Image &band = pyr[i];
+            if(i == int(pyr.size()) - 1){
+                // detach the finest level from the source image
+                Image copy(band.rows, band.cols, band.type());
+                const float *src = pyramid::row(band, 0);
+                std::copy(src, src + band.rows * band.cols * band.channels(), pyramid::row(copy, 0));
+                band = copy;
+            }
+            pyrExpandAdd(pyr[i - 1], band, -1.0f);
+        }
+    }
+
+    /**
+     * \brief Laplacian pyramid from the finest image
+     */
+    inline std::vector<Image> laplacianPyramid(const Image &img, int levels = -1) {
+        std::vector<Image> pyr = gaussianPyramid(img, levels);
+        gaussianToLaplacian(pyr);
+        return pyr;
+    }
+
+    /**
+     * \brief Collapse a laplacian pyramid in place (toolbox/pyr_collapse.m)
+     *
+     * Each level is accumulated into the next finer one, so that the pyramid
+     * becomes the gaussian one.
+     *
+     * \return the finest level
+     */
+    inline Image pyrCollapse(std::vector<Image> &pyr) {
+        assert(!pyr.empty() && "Collapsing an empty pyramid");
+        for(size_t i = 0; i + 1 < pyr.size(); ++i){
+            pyrExpandAdd(pyr[i], pyr[i + 1]);
+        }
+        return pyr.back();
+    }
+
+}
+
+#endif	/* IMAGE_PYRAMID_H */
+
@@ -0,0 +1,141 @@
+/*
+ * File:   resize.h
+ */
+
+#ifndef IMAGE_RESIZE_H
+#define	IMAGE_RESIZE_H
+
+#include "../math/mat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace pm {
+
+    namespace resampling {
+
+        /**
+         * Contributions of input samples to one output sample
+         */
+        struct Contrib {
+            int first;
+            std::vector<float> weights;
+        };
+
+        /**
+         * Triangle (bilinear) kernel, widened when downsampling (antialiasing)
+         * as done by Matlab's imresize
+         */
+        inline std::vector<Contrib> contributions(int inSize, int outSize) {
+            std::vector<Contrib> list(outSize);
+            const float scale = float(outSize) / float(inSize);
+            const float kscale = std::min(scale, 1.0f);
+            const float support = 1.0f / kscale;
+            for(int o = 0; o < outSize; ++o){
+                // center of the output sample in input coordinates
+                float u = (o + 0.5f) / scale - 0.5f;
+                int left = std::floor(u - support);
+                int right = std::ceil(u + support);
+                Contrib &c = list[o];
+                c.first = left;
+                float sum = 0.0f;
+                for(int i = left; i <= right; ++i){
+                    float w = kscale * std::max(0.0f, 1.0f - std::abs((u - i) * kscale));
+                    c.weights.push_back(w);
+                    sum += w;
+                }
+                if(sum > 0.0f){
+                    for(float &w : c.weights) w /= sum;
+                }
+            }
+            return list;
+        }
+
+        // symmetric (replicated) border
+        inline int clampIndex(int i, int size) {
+            return std::max(0, std::min(size - 1, i));
+        }
+    }
+
+    /**
+     * \brief Resize a floating point image (any number of channels)
+     *
+     * \param src
+     *          the source image (IM_32FC(n))
+     * \param rows
+     *          the new number of rows
+     * \param cols
+     *          the new number of columns
+     * \return the resized image
+     */
+    inline Image resize(const Image &src, int rows, int cols) {
+        assert(src.depth() == IM_32F && "Resize only supports float images");
+        const int ch = src.channels();
+        std::vector<resampling::Contrib> cx = resampling::contributions(src.cols, cols);
+        std::vector<resampling::Contrib> cy = resampling::contributions(src.rows, rows);
+
+        // horizontal pass
+        Image tmp = Image::zeros(src.rows, cols, IM_32FC(ch));
+        for(int y = 0; y < src.rows; ++y){
+            for(int x = 0; x < cols; ++x){
+                const resampling::Contrib &c = cx[x];
+                float *out = tmp.ptr<float>(y, x);
+                for(int j = 0, n = c.weights.size(); j < n; ++j){
+                    const float w = c.weights[j];
+                    if(w == 0.0f) continue;
+                    const float *in = src.ptr<float>(y, resampling::clampIndex(c.first + j, src.cols));
+                    for(int k = 0; k < ch; ++k) out[k] += w * in[k];
+                }
+            }
+        }
+
+        // vertical pass
+        Image dst = Image::zeros(rows, cols, IM_32FC(ch));
+        for(int y = 0; y < rows; ++y){
+            const resampling::Contrib &c = cy[y];
+            for(int j = 0, n = c.weights.size(); j < n; ++j){
+                const float w = c.weights[j];
+                if(w == 0.0f) continue;
+                const int sy = resampling::clampIndex(c.first + j, src.rows);
+                for(int x = 0; x < cols; ++x){
+                    const float *in = tmp.ptr<float>(sy, x);
+                    float *out = dst.ptr<float>(y, x);
+                    for(int k = 0; k < ch; ++k) out[k] += w * in[k];
+                }
+            }
+        }
+        return dst;
+    }
+
+    /**
+     * \brief Extract a rectangular region of an image (copy)
+     */
+    inline Image crop(const Image &src, int y0, int x0, int rows, int cols) {
+        assert(y0 >= 0 && x0 >= 0 && y0 + rows <= src.rows && x0 + cols <= src.cols && "Crop out of bounds");
+        Image dst(rows, cols, src.type());
+        const size_t rowBytes = size_t(cols) * src.elemSize();
+        for(int y = 0; y < rows; ++y){
+            const byte *in = src.ptr<byte>(y0 + y, x0);
+            std::copy(in, in + rowBytes, dst.ptr<byte>(y, 0));
+        }
+        return dst;
+    }
+
+    /**
+     * \brief Resize an image so that it covers (M x M) and crop its center
+     *
+     * @see libs/gist/imresizecrop.m
+     */
+    inline Image resizeCrop(const Image &src, int M) {
+        float scaling = std::max(float(M) / src.rows, float(M) / src.cols);
+        int rows = std::max(M, int(round(src.rows * scaling)));
+        int cols = std::max(M, int(round(src.cols * scaling)));
+        Image img = resize(src, rows, cols);
+        return crop(img, (rows - M) / 2, (cols - M) / 2, M, M);
+    }
+
+}
+
+#endif	/* IMAGE_RESIZE_H */
+
@@ -0,0 +1,86 @@
+/*
+ * File:   image_pyramid.cpp
+ */
+
+#define USE_MATLAB 1
+
+#include "image/pyramid.h"
+#include "matlab.h"
+
+using namespace pm;
+
+template <typename From, typename To>
+Image convertImage(const Image &img, int depth) {
+    const int C = img.channels();
+    Image out(img.rows, img.cols, IM_MAKETYPE(depth, C));
+    for(int y = 0; y < img.rows; ++y){
+        for(int x = 0; x < img.cols; ++x){
+            const From *src = img.ptr<From>(y, x);
+            To *dst = out.ptr<To>(y, x);
+            for(int c = 0; c < C; ++c){
+                dst[c] = To(src[c]);
+            }
+        }
+    }
+    return out;
+}
+
+/**
+ * Usage:
+ *
+ * pyr = impyr( img, type, levels )
+ *
+ * where type is 'gaussian' or 'laplacian' (default),
+ * and levels is the number of reductions (default: pyr_levels(img)).
+ *
+ * The result is a cell array from 1=coarsest to end=finest, of the same
+ * class as img (double or single), as get_pyramid in stereo_synth.m.
+ */
+void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
+    // checking the input
+	if (nin < 1 || nin > 3) {
+		mexErrMsgIdAndTxt("MATLAB:pyr:invalidNumInputs",
+				"Requires 1 to 3 arguments! (#in = %d)", nin);
+	}
+	// checking the output
+	if (nout > 1) {
+		mexErrMsgIdAndTxt("MATLAB:pyr:maxlhs",
+				"Too many output arguments.");
+	}
+
+    // the pyramid type
+    bool laplacian = true;
+    if(nin >= 2 && !mxIsEmpty(in[1])){
+        if(mxStringEquals(in[1], "gaussian")){
+            laplacian = false;
+        } else if(!mxStringEquals(in[1], "laplacian")){
+            mexErrMsgIdAndTxt("MATLAB:pyr:invalidType", "Unsupported type of pyramid!");
+        }
+    }
+    int levels = -1;
+    if(nin >= 3 && !mxIsEmpty(in[2])){
+        levels = mxCheckedScalar(in[2], "Invalid number of levels");
+    }
+
+    // the pyramid is computed in single precision
+    const bool isDouble = mxIsDouble(in[0]);
+    if(!isDouble && !mxIsSingle(in[0])){
+        mexErrMsgIdAndTxt("MATLAB:pyr:invalidImage", "The image must be of class single or double!");
+    }
+    Image img = mxArrayToImage(in[0]);
+    if(isDouble){
+        img = convertImage<double, float>(img, IM_32F);
+    }
+    std::vector<Image> pyr = laplacian ? laplacianPyramid(img, levels) : gaussianPyramid(img, levels);
+
+    // output cell array
+    if(nout > 0){
+        out[0] = mxCreateCellMatrix(1, pyr.size());
+        for(size_t l = 0; l < pyr.size(); ++l){
+            mxArray *level = isDouble
+                    ? mxImageToArray<double>(convertImage<float, double>(pyr[l], IM_64F))
+                    : mxImageToArray<float>(pyr[l]);
+            mxSetCell(out[0], l, level);
+        }
+    }
+}
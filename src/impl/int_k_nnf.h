@@ -17,6 +17,8 @@
 #include "../nnf/patch.h"
 #include "../nnf/distance.h"
 #include "../nnf/field.h"
+#include "../nnf/memo.h"
+#include "../nnf/compact.h"
 #include "../nnf/nnf.h"
 #include "../sampling/uniform.h"
 
@@ -43,7 +45,7 @@ namespace pm {
 
         NearestNeighborField(const Image &src, const Image &trg, const DistanceFunc d, const RNG r = unif01)
         : Field2D(src.width - Patch2ti::width() + 1, src.height - Patch2ti::width() + 1),
-          source(src), target(trg), distFunc(d), rand(r), k(K) {
+          source(src), target(trg), distFunc(d), rand(r), k(K), memo(NULL) {
             data = createEntry<PatchData[K]>("patches");
         }
 		
@@ -62,6 +64,7 @@ namespace pm {
         typedef Heap<K, PatchData, DistanceCompare> MaxHeap;
 
         Entry<PatchData[K]> data;
+        RejectMemo *memo; //!< optional memo of the rejected patches (@see kTryPatch)
 
         float dist(const Point2i &pos, const Patch2ti &q) const {
             const Patch2ti p(pos);
@@ -112,6 +115,14 @@ namespace pm {
             return ok;
         }
 
+        // --- compact storage (@see nnf/compact.h) ----------------------------
+        bool compact(Mat &m) const {
+            return compactEntries<K, PatchData>(data, m);
+        }
+        void loadCompact(const Mat &m) {
+            expandEntries<K, PatchData>(m, data);
+        }
+
     #if USE_MATLAB
         void load(const mxArray *d){
             if(mxGetNumberOfElements(d) > 0){
@@ -16,9 +16,12 @@
 
 #include "../algebra.h"
 #include "../data/heap.h"
+#include "../math/imageset.h"
 #include "../nnf/patch.h"
 #include "../nnf/distance.h"
 #include "../nnf/field.h"
+#include "../nnf/memo.h"
+#include "../nnf/compact.h"
 #include "../nnf/nnf.h"
 #include "../sampling/uniform.h"
 
@@ -48,8 +51,9 @@ namespace pm {
 
         NearestNeighborField(const Image &src, const ImageSet &trg, const DistanceFunc d, const RNG r = unif01)
         : Field2D(src.width - TargetPatch::width() + 1, src.height - TargetPatch::width() + 1),
-          source(src), targets(trg), distFunc(d), rand(r), k(K) {
+          source(src), targets(trg), distFunc(d), rand(r), k(K), memo(NULL) {
             data = createEntry<PatchData[K]>("patches");
+            best = createEntry<PatchData>("best");
         }
 		
 		struct PatchData {
@@ -67,6 +71,8 @@ namespace pm {
         typedef Heap<K, PatchData, DistanceCompare> MaxHeap;
 
         Entry<PatchData[K]> data;
+        Entry<PatchData> best; //!< best entry of each heap, tracked by store()
+        RejectMemo *memo; //!< optional memo of the rejected patches (@see kTryPatch)
 
         float dist(const Point2i &pos, const TargetPatch &q) const {
             const SourcePatch p(pos);
@@ -88,7 +94,18 @@ namespace pm {
             return false;
         }
         inline bool store(const Point2i &i, const TargetPatch &p, const float &d) {
-            return MaxHeap(data.at(i)).insert(PatchData(p, d));
+            if(MaxHeap(data.at(i)).insert(PatchData(p, d))){
+                PatchData &b = best.at(i);
+                if(d < b.distance){
+                    b = PatchData(p, d);
+                }
+                return true;
+            }
+            return false;
+        }
+        //! best of the k entries (without scanning the heap)
+        inline const PatchData &top(const Point2i &i) const {
+            return best.at(i);
         }
         inline FrameSize targetSize(size_t n) const {
             return FrameSize(targets[n].width, targets[n].height);
@@ -106,6 +123,8 @@ namespace pm {
                 p[k].distance = std::numeric_limits<float>::infinity();
             }
 			MaxHeap heap(&p[0]);
+            PatchData &b = best.at(i);
+            b = p[0];
             int ok = 0;
 			for(int k = 0; k < K; ++k){
                 // choose image to sample from
@@ -120,10 +139,41 @@ namespace pm {
                 PatchData pd(q, dist(i, q));
                 // need the distance to insert in the heap
 				if(heap.insert(pd)) ++ok;
+                if(pd.distance < b.distance) b = pd;
 			}
             return ok;
         }
 
+        //! find the best entries after external changes of the heaps
+        void updateBest() {
+            for(const Point2i &i : *this){
+                const PatchData (&p)[K] = data.at(i);
+                PatchData &b = best.at(i);
+                b = p[0];
+                for(int k = 1; k < K; ++k){
+                    if(p[k].distance < b.distance) b = p[k];
+                }
+            }
+        }
+
+        // --- raw storage (@see io/cache.h) ------------------------------------
+        void load(const Mat &m) {
+            data = attachEntry<PatchData[K]>("patches", m);
+            updateBest();
+        }
+        inline const Mat &raw() const {
+            return data;
+        }
+
+        // --- compact storage (@see nnf/compact.h) ----------------------------
+        bool compact(Mat &m) const {
+            return compactEntries<K, PatchData>(data, m);
+        }
+        void loadCompact(const Mat &m) {
+            expandEntries<K, PatchData>(m, data);
+            updateBest();
+        }
+
     #if USE_MATLAB
         void load(const mxArray *d){
             if(mxGetNumberOfElements(d) > 0){
@@ -138,6 +188,7 @@ namespace pm {
 						p[k].distance = m.read<float>(i.y, i.x, 4 * k + 3);
 					}
                 }
+                updateBest();
             } else {
                 for(const Point2i &i : *this){
                     int k = init(i);
@@ -158,6 +209,7 @@ namespace pm {
                 // reorder heap
                 MaxHeap(&p[0]).build();
             }
+            updateBest();
         }
 
         mxArray *save() const {
@@ -30,11 +30,11 @@ namespace pm {
         Frame2D<Point2i, true> frame() const {
             return Frame2D<Point2i, true>(FrameSize(nnf->source.width, nnf->source.height));
         }
-        const vec &pixel(const PixelLoc &p) const {
+        vec pixel(const PixelLoc &p) const {
 #ifdef DEBUG_STRICT_TEST
-            assert(nnf->target.contains(p) && "Patch out of bounds");
+            assert(p.index >= 0 && size_t(p.index) < images->size() && (*images)[p.index].contains(Point2i(p.x, p.y)) && "Patch out of bounds");
 #endif			
-            return nnf->targets.template at<vec>(p);
+            return images->template at<vec>(p);
         }
         SubFrame2D<Point2i, true> overlap(const Point2i &p) const {
 #ifdef DEBUG_STRICT_TEST
@@ -58,10 +58,13 @@ namespace pm {
             return nnf->distance(i, k);
         }
 
-        PixelContainer(NNF *n) : nnf(n) {}
+        PixelContainer(NNF *n) : nnf(n), images(&n->targets) {}
+        //! vote the pixels of other images with the same layout (e.g. right frames)
+        PixelContainer(NNF *n, const ImageSet *imgs) : nnf(n), images(imgs) {}
         
     private:
         NNF *nnf;
+        const ImageSet *images;
     };
     
 }
@@ -0,0 +1,653 @@
+/*
+ * File:   stereo_synth.h
+ */
+
+#ifndef IMPL_STEREO_SYNTH_H
+#define	IMPL_STEREO_SYNTH_H
+
+#ifndef USE_MATLAB
+#define USE_MATLAB 0
+#endif
+
+#ifndef SYNTH_K
+#define SYNTH_K 7
+#endif
+
+#include "ix_k_nnf.h"
+#include "ix_nnf_container.h"
+#include "../gist/gist.h"
+#include "../image/pyramid.h"
+#include "../math/filter.h"
+#include "../nnf/algorithm.h"
+#include "../nnf/propagation.h"
+#include "../nnf/trypatch.h"
+#include "../nnf/uniformsearch.h"
+#include "../perf.h"
+#include "../scanline.h"
+#include "../voting/weighted_average.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+namespace pm {
+
+    /**
+     * Parameters of the stereo synthesis (defaults of toolbox/stereo_synth.m)
+     */
+    struct SynthParams {
+        int patchSize;
+        int iterations;
+        int levels;         // pyramid reductions (-1 = pyramidLevels)
+        bool laplacian;     // laplacian or gaussian pyramid
+        double memory;      // exemplar memory budget in bytes (pm_select)
+        int minTargets;     // minimum number of exemplars
+        int targets;        // fixed number of exemplars (0 = from the budget)
+        float voteSigma;    // sigma of the gaussian vote filter
+        bool knnVote;       // vote with all the k entries instead of the best one
+        float knnSigma2;    // scale of the k-NN vote weights (<= 0 for automatic)
+        int k;              // number of k-NNF entries (one of synthKValues())
+        double budget;      // total memory budget in bytes (0 = none, @see synth_plan.h)
+        bool incremental;   // start each level from the k-NNF of the previous one
+        float pruneThreshold; // share of the k-NNF entries to keep an exemplar for the finer levels (0 = keep all)
+        bool rejectMemo;    // skip the distance of the patches already rejected (@see memo.h)
+
+        SynthParams() : patchSize(7), iterations(6), levels(-1), laplacian(true),
+                        memory(50e6), minTargets(5), targets(0), voteSigma(1.0f),
+                        knnVote(false), knnSigma2(0.0f), k(SYNTH_K), budget(0.0),
+                        incremental(false), pruneThreshold(0.0f), rejectMemo(false) {}
+    };
+
+    namespace synth {
+
+        typedef Patch2tix TargetPatch;
+        typedef NearestNeighborField<TargetPatch, float, 1> NNF;
+        typedef NearestNeighborField<TargetPatch, float, SYNTH_K> kNNF;
+        template <int K>
+        using kNNFOf = NearestNeighborField<TargetPatch, float, K>;
+
+        //! gaussian filter as fspecial('gaussian', [n n], sigma)
+        inline Filter voteFilter(int n, float sigma) {
+            Filter f(n, 0.0f);
+            const float mid = (n - 1) * 0.5f;
+            for(int y = 0; y < n; ++y){
+                for(int x = 0; x < n; ++x){
+                    float dx = x - mid, dy = y - mid;
+                    f[y][x] = std::exp(-(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+                }
+            }
+            f.normalize();
+            return f;
+        }
+
+        template <int channels = 1>
+        struct VoteOperation {
+
+            typedef VoteOperation<channels + 1> Next;
+
+            Image compute() const {
+                PixelContainer<channels, TargetPatch, float, 1> data(nnf);
+                return scatter_average(data, *filter);
+            }
+
+            VoteOperation(const VoteOperation<channels - 1> &v) : nnf(v.nnf), filter(v.filter) {}
+            VoteOperation(NNF *n, const Filter *f) : nnf(n), filter(f) {}
+
+            NNF *nnf;
+            const Filter *filter;
+        };
+
+        //! vote of all the k-nnf entries from other targets (e.g. right frames)
+        template <int channels = 1, int K = SYNTH_K>
+        struct KnnVoteOperation {
+
+            typedef KnnVoteOperation<channels + 1, K> Next;
+
+            Image compute() const {
+                PixelContainer<channels, TargetPatch, float, K> data(knnf, images);
+                return knn_average(data, *filter, sigma2);
+            }
+
+            KnnVoteOperation(const KnnVoteOperation<channels - 1, K> &v) : knnf(v.knnf), images(v.images), filter(v.filter), sigma2(v.sigma2) {}
+            KnnVoteOperation(kNNFOf<K> *n, const ImageSet *imgs, const Filter *f, float s) : knnf(n), images(imgs), filter(f), sigma2(s) {}
+
+            kNNFOf<K> *knnf;
+            const ImageSet *images;
+            const Filter *filter;
+            float sigma2;
+        };
+
+    }
+
+    /**
+     * \brief Memory footprint of the synthesis (bytes)
+     *
+     * Only the buffers that live through the synthesis are counted
+     * (not the transient vote accumulators).
+     */
+    struct SynthFootprint {
+        size_t nnf;          //!< k-NNF and top-1 NNF entries (finest level)
+        size_t exemplars;    //!< exemplar frames and pyramids
+        size_t query;        //!< query pyramid and synthesized levels
+        size_t descriptors;  //!< exemplar gists
+
+        SynthFootprint() : nnf(0), exemplars(0), query(0), descriptors(0) {}
+
+        inline size_t total() const {
+            return nnf + exemplars + query + descriptors;
+        }
+    };
+
+    //! values of SynthParams::k with a compiled synthesis, in increasing order
+    inline const std::vector<int> &synthKValues() {
+        static std::vector<int> values;
+        if(values.empty()){
+            const int k[] = { 3, 5, 9, SYNTH_K };
+            values.assign(k, k + 4);
+            std::sort(values.begin(), values.end());
+            values.erase(std::unique(values.begin(), values.end()), values.end());
+        }
+        return values;
+    }
+
+    //! number of pyramid reductions for a query (exemplars may need less)
+    inline int synthLevels(const SynthParams &params, int rows, int cols) {
+        if(!params.laplacian){
+            return 0;
+        }
+        return params.levels < 0 ? pyramidLevels(rows, cols) : params.levels;
+    }
+
+    /**
+     * \brief Number of exemplars to select (@see toolbox/pm_select.m)
+     *
+     * \param numPixels
+     *          the average number of pixels of the exemplar left frames
+     */
+    inline int targetNumber(const SynthParams &params, size_t numExemplars, double numPixels) {
+        int K = params.targets;
+        if(K <= 0){
+            K = std::ceil(params.memory / (8.0 * std::max(1.0, numPixels)));
+            K = std::max(params.minTargets, K);
+        }
+        return std::min<int>(numExemplars, K);
+    }
+
+    /**
+     * \brief Select the K exemplars of closest gist (knnsearch in pm_select.m)
+     *
+     * \param query
+     *          the query gist
+     * \param gists
+     *          the exemplar gists (N rows of query.size() floats)
+     * \return the K indices from the closest to the farthest
+     */
+    inline std::vector<int> selectExemplars(const std::vector<float> &query, const float *gists, int N, int K) {
+        const int D = query.size();
+        std::vector< std::pair<double, int> > dist(N);
+        for(int n = 0; n < N; ++n){
+            const float *g = gists + size_t(n) * D;
+            double d = 0.0;
+            for(int i = 0; i < D; ++i){
+                double e = g[i] - query[i];
+                d += e * e;
+            }
+            dist[n] = std::make_pair(d, n);
+        }
+        K = std::min(K, N);
+        std::partial_sort(dist.begin(), dist.begin() + K, dist.end());
+        std::vector<int> group(K);
+        for(int k = 0; k < K; ++k){
+            group[k] = dist[k].second;
+        }
+        return group;
+    }
+
+    /**
+     * \brief Best entries of a k-NNF (as ixknnf_top), pointing to other targets
+     *
+     * \param knnf
+     *          the k-NNF from the query to the left frames
+     * \param nnf
+     *          the 1-NNF from the query to the right frames
+     */
+    template <int K>
+    inline void storeTop(const NearestNeighborField<synth::TargetPatch, float, K> &knnf, synth::NNF *nnf) {
+        for(const Point2i &i : knnf){
+            const typename NearestNeighborField<synth::TargetPatch, float, K>::PatchData &p = knnf.top(i);
+            nnf->store(i, p.patch, p.distance);
+        }
+    }
+
+    /**
+     * \brief Vote the right frames from the best k-NNF entries (ixknnf_top then ixvote)
+     */
+    template <int K>
+    inline Image transferTop(const NearestNeighborField<synth::TargetPatch, float, K> &knnf, const ImageSet &rights, const Filter &filter) {
+        using namespace synth;
+        NNF nnf(knnf.source, rights, knnf.distFunc);
+        storeTop(knnf, &nnf);
+        VoteOperation<1> op(&nnf, &filter);
+        return vote(op, knnf.source.channels());
+    }
+
+    /**
+     * \brief Number of k-NNF entries pointing to each exemplar
+     */
+    template <int K>
+    inline std::vector<size_t> exemplarUsage(const NearestNeighborField<synth::TargetPatch, float, K> &knnf) {
+        std::vector<size_t> usage(knnf.targetCount(), 0);
+        for(const Point2i &i : knnf){
+            const typename NearestNeighborField<synth::TargetPatch, float, K>::PatchData (&p)[K] = knnf.data.at(i);
+            for(int k = 0; k < K; ++k){
+                const int z = p[k].patch.index;
+                if(z >= 0 && z < int(usage.size())){
+                    ++usage[z];
+                }
+            }
+        }
+        return usage;
+    }
+
+    /**
+     * \brief Exemplars to keep given their usage
+     *
+     * \param threshold
+     *          minimum share of the entries for an exemplar to be kept
+     *          (the most used one is always kept)
+     * \return the new index of each exemplar (-1 when dropped)
+     */
+    inline std::vector<int> pruneExemplars(const std::vector<size_t> &usage, float threshold) {
+        size_t total = 0, best = 0;
+        for(size_t n = 0; n < usage.size(); ++n){
+            total += usage[n];
+            if(usage[n] > usage[best]) best = n;
+        }
+        std::vector<int> map(usage.size(), -1);
+        int next = 0;
+        for(size_t n = 0; n < usage.size(); ++n){
+            if(n == best || usage[n] >= threshold * total){
+                map[n] = next++;
+            }
+        }
+        return map;
+    }
+
+    //! most exemplars that pruneExemplars can keep (each has at least threshold of the entries)
+    inline int maxKeptExemplars(float threshold) {
+        return std::max(1, int(1.0 / threshold + 1e-6));
+    }
+
+    /**
+     * \brief Remap the exemplar indices of a k-NNF in place
+     *
+     * Entries of dropped exemplars get the index -1 and an infinite
+     * distance, so that they are the first to be replaced.
+     */
+    template <int K>
+    inline void remapExemplars(NearestNeighborField<synth::TargetPatch, float, K> &knnf, const std::vector<int> &map) {
+        typedef NearestNeighborField<synth::TargetPatch, float, K> kNNF;
+        for(const Point2i &i : knnf){
+            typename kNNF::PatchData (&p)[K] = knnf.data.at(i);
+            for(int k = 0; k < K; ++k){
+                const int z = p[k].patch.index;
+                const int newZ = z >= 0 && z < int(map.size()) ? map[z] : -1;
+                p[k].patch.index = newZ;
+                if(newZ < 0){
+                    p[k].distance = std::numeric_limits<float>::infinity();
+                }
+            }
+            typename kNNF::MaxHeap(&p[0]).build();
+        }
+        knnf.updateBest();
+    }
+
+    /**
+     * \brief Initialize a k-NNF from the one of the previous (coarser) level
+     *
+     * Each entry is randomly initialized, then the coarse entries are
+     * upsampled (positions times 2) and tried in its place.
+     * The exemplar indices of both fields must match (@see remapExemplars).
+     */
+    template <int K>
+    inline void initFromCoarse(NearestNeighborField<synth::TargetPatch, float, K> &knnf,
+            const NearestNeighborField<synth::TargetPatch, float, K> &coarse) {
+        using namespace synth;
+        const int P = TargetPatch::width();
+        for(const Point2i &i : knnf){
+            int n = knnf.init(i);
+            while(n < K){
+                n += knnf.init(i);
+            }
+            const Point2i c(std::min(i.x / 2, coarse.width - 1), std::min(i.y / 2, coarse.height - 1));
+            for(int k = 0; k < K; ++k){
+                const TargetPatch &q = coarse.data.at(c)[k].patch;
+                if(q.index < 0 || q.index >= int(knnf.targetCount())) continue;
+                const FrameSize size = knnf.targetSize(q.index);
+                Point2i pos(q.x * 2 + i.x - c.x * 2, q.y * 2 + i.y - c.y * 2);
+                pos.x = std::max(0, std::min(pos.x, size.width - P));
+                pos.y = std::max(0, std::min(pos.y, size.height - P));
+                kTryPatch<K, TargetPatch, float>(&knnf, i, TargetPatch(pos, q.index));
+            }
+        }
+    }
+
+    /**
+     * \brief One level of synthesis: k-NNF, top-1 and vote
+     *
+     * Equivalent to the ixknnf, ixknnf_top and ixvote sequence of
+     * toolbox/stereo_synth.m with a patch transfer.
+     *
+     * \param knnf
+     *          the k-NNF from the query to the left frames (not initialized)
+     * \param rights
+     *          the right frames corresponding to the left ones
+     * \param usage
+     *          if not NULL, its nnf field gets the largest memory of the fields
+     * \param coarse
+     *          if not NULL, the k-NNF of the previous level to start from
+     * \return the voted right frame
+     */
+    template <int K>
+    inline Image synthesizeLevel(NearestNeighborField<synth::TargetPatch, float, K> &knnf, const ImageSet &rights,
+            const SynthParams &params, SynthFootprint *usage = NULL,
+            const NearestNeighborField<synth::TargetPatch, float, K> *coarse = NULL) {
+        using namespace synth;
+        const Image &query = knnf.source;
+        {
+            PerfScope perf("ixknnf", "init");
+            if(coarse){
+                initFromCoarse(knnf, *coarse);
+            } else {
+                for(const Point2i &i : knnf){
+                    int k = knnf.init(i);
+                    while(k < K){
+                        k += knnf.init(i);
+                    }
+                }
+            }
+        }
+        auto seq = Algorithm()  << UniformSearch<TargetPatch, float, K>(&knnf)
+                                << Propagation<TargetPatch, float, K>(&knnf);
+        NoOp<Point2i> noFilter;
+        PerfIterations iterEnd("ixknnf");
+        RejectMemo memo(params.rejectMemo ? knnf.width : 0, knnf.height); // empty if unused
+        if(params.rejectMemo){
+            knnf.memo = &memo;
+        }
+        iterEnd.start();
+        scanline(knnf, params.iterations, seq, noFilter, iterEnd);
+        iterEnd.stop();
+        knnf.memo = NULL;
+
+        // best of k (tracked by the k-nnf) or all k, voted from the right frames
+        const size_t fields = knnf.memory() + (coarse ? coarse->memory() : 0) + memo.memory();
+        Filter filter = voteFilter(params.patchSize, params.voteSigma);
+        if(params.knnVote){
+            if(usage){
+                usage->nnf = std::max(usage->nnf, fields);
+            }
+            PerfScope perf("ixvote", "knn_vote");
+            KnnVoteOperation<1, K> op(&knnf, &rights, &filter, params.knnSigma2);
+            return vote(op, query.channels());
+        }
+        NNF nnf(query, rights, knnf.distFunc);
+        {
+            PerfScope perf("ixknnf_top", "top");
+            storeTop(knnf, &nnf);
+        }
+        if(usage){
+            usage->nnf = std::max(usage->nnf, fields + nnf.memory());
+        }
+        PerfScope perf("ixvote", "vote");
+        VoteOperation<1> op(&nnf, &filter);
+        return vote(op, query.channels());
+    }
+
+    /**
+     * \brief One level of synthesis from the query and the exemplar frames
+     *
+     * \param query
+     *          the left query image (float)
+     * \param lefts
+     *          the left frames of the exemplars
+     * \param rights
+     *          the corresponding right frames
+     */
+    template <int K>
+    inline Image synthesizeLevel(const Image &query, const ImageSet &lefts, const ImageSet &rights, const SynthParams &params,
+            SynthFootprint *usage = NULL) {
+        using namespace synth;
+        TargetPatch::width(params.patchSize);
+        DistanceFunc d = DistanceFactory<TargetPatch, float, ImageSet>::get(dist::SSD, query.channels());
+        kNNFOf<K> knnf(query, lefts, d);
+        return synthesizeLevel<K>(knnf, rights, params, usage);
+    }
+
+    /**
+     * \brief One level of synthesis with params.k entries in the k-NNF
+     *
+     * The values of synthKValues() are compiled, any other uses SYNTH_K.
+     */
+    inline Image synthesizeLevel(const Image &query, const ImageSet &lefts, const ImageSet &rights, const SynthParams &params,
+            SynthFootprint *usage = NULL) {
+        switch(params.k){
+            case 3: return synthesizeLevel<3>(query, lefts, rights, params, usage);
+            case 5: return synthesizeLevel<5>(query, lefts, rights, params, usage);
+            case 9: return synthesizeLevel<9>(query, lefts, rights, params, usage);
+            default:
+                assert(params.k == SYNTH_K && "Synthesis with a k that is not compiled (see synthKValues)");
+                return synthesizeLevel<SYNTH_K>(query, lefts, rights, params, usage);
+        }
+    }
+
+    /**
+     * \brief Exemplar frames, loaded by the synthesis when it needs them
+     */
+    struct ExemplarSource {
+        virtual ~ExemplarSource() {}
+        virtual size_t size() const = 0;
+        //! size of the left frame (without loading it if possible)
+        virtual FrameSize frameSize(size_t n) const = 0;
+        //! left and right frames of an exemplar
+        virtual void load(size_t n, Image *left, Image *right) const = 0;
+        //! memory kept by the source itself (0 if the frames are loaded on demand)
+        virtual size_t memory() const {
+            return 0;
+        }
+    };
+
+    /**
+     * \brief Exemplar frames already in memory
+     */
+    struct ExemplarImages : public ExemplarSource {
+        ExemplarImages(const std::vector<Image> &l, const std::vector<Image> &r) : lefts(l), rights(r) {
+            assert(lefts.size() == rights.size() && "Invalid exemplars");
+        }
+        virtual size_t size() const {
+            return lefts.size();
+        }
+        virtual FrameSize frameSize(size_t n) const {
+            return FrameSize(lefts[n].cols, lefts[n].rows);
+        }
+        virtual void load(size_t n, Image *left, Image *right) const {
+            *left = lefts[n];
+            *right = rights[n];
+        }
+        virtual size_t memory() const {
+            size_t bytes = 0;
+            for(size_t n = 0; n < lefts.size(); ++n){
+                bytes += lefts[n].memory() + rights[n].memory();
+            }
+            return bytes;
+        }
+
+    private:
+        const std::vector<Image> &lefts;
+        const std::vector<Image> &rights;
+    };
+
+    /**
+     * \brief Multi-scale synthesis over the query and exemplar pyramids with K entries
+     *
+     * @see synthesize
+     */
+    template <int K>
+    inline Image synthesize(const Image &query, const ExemplarSource &source, const SynthParams &params,
+            SynthFootprint *usage = NULL) {
+        using namespace synth;
+        typedef boost::shared_ptr< kNNFOf<K> > FieldPtr;
+        const size_t N = source.size();
+        assert(N > 0 && "Synthesis without exemplar");
+        int levels = synthLevels(params, query.rows, query.cols);
+        if(params.laplacian && params.levels < 0){
+            // the coarsest level must be valid for all images
+            for(size_t n = 0; n < N; ++n){
+                const FrameSize size = source.frameSize(n);
+                levels = std::min(levels, pyramidLevels(size.rows, size.cols));
+            }
+        }
+        std::vector<Image> queryPyr = laplacianPyramid(query, levels);
+        if(usage){
+            // without reduction, the pyramid shares the image
+            for(int l = 0; l <= levels && levels > 0; ++l){
+                usage->query += queryPyr[l].memory();
+            }
+        }
+
+        // exemplar pyramids
+        // => when the pruning must drop some exemplars, only the gaussian
+        //    reductions to the coarsest level are computed first, and the
+        //    exemplars it keeps are loaded again for their full pyramids
+        //    (less memory, at the cost of decoding the kept frames twice)
+        const bool lazy = levels > 0 && params.pruneThreshold > 0.0f
+                       && maxKeptExemplars(params.pruneThreshold) < int(N);
+        std::vector< std::vector<Image> > leftPyr(N), rightPyr(N);
+        std::vector<bool> complete(N, false);
+        auto loadPyramids = [&](size_t n, bool full) {
+            Image left, right;
+            source.load(n, &left, &right);
+            if(full){
+                leftPyr[n] = laplacianPyramid(left, levels);
+                rightPyr[n] = laplacianPyramid(right, levels);
+            } else {
+                leftPyr[n].assign(levels + 1, Image());
+                rightPyr[n].assign(levels + 1, Image());
+                leftPyr[n][0] = pyramidTop(left, levels);
+                rightPyr[n][0] = pyramidTop(right, levels);
+            }
+            complete[n] = full;
+        };
+        // pyramids share the frames of the source without reduction
+        const bool countPyramids = levels > 0 || source.memory() == 0;
+        size_t peak = 0;
+        auto trackMemory = [&]() {
+            size_t bytes = 0;
+            for(size_t n = 0; n < N && countPyramids; ++n){
+                for(size_t l = 0; l < leftPyr[n].size(); ++l){
+                    bytes += leftPyr[n][l].memory() + rightPyr[n][l].memory();
+                }
+            }
+            peak = std::max(peak, bytes);
+        };
+        for(size_t n = 0; n < N; ++n){
+            loadPyramids(n, !lazy);
+        }
+        trackMemory();
+
+        TargetPatch::width(params.patchSize);
+        DistanceFunc d = DistanceFactory<TargetPatch, float, ImageSet>::get(dist::SSD, query.channels());
+        std::vector<int> active(N); // exemplars still in use
+        for(size_t n = 0; n < active.size(); ++n){
+            active[n] = n;
+        }
+        std::vector<Image> result(levels + 1);
+        FieldPtr coarse;
+        for(int l = 0; l <= levels; ++l){
+            // the exemplars kept by the pruning get their full pyramids
+            for(size_t n = 0; n < active.size() && l > 0; ++n){
+                if(!complete[active[n]]){
+                    loadPyramids(active[n], true);
+                }
+            }
+            trackMemory();
+            ImageSet L(active.size()), R(active.size());
+            for(size_t n = 0; n < active.size(); ++n){
+                L[n] = leftPyr[active[n]][l];
+                R[n] = rightPyr[active[n]][l];
+            }
+            FieldPtr knnf(new kNNFOf<K>(queryPyr[l], L, d));
+            result[l] = synthesizeLevel<K>(*knnf, R, params, usage, params.incremental ? coarse.get() : NULL);
+            if(usage){
+                usage->query += result[l].memory();
+            }
+            // drop the exemplars that are barely used for the finer levels
+            if(l < levels && params.pruneThreshold > 0.0f){
+                std::vector<int> map = pruneExemplars(exemplarUsage(*knnf), params.pruneThreshold);
+                std::vector<int> kept;
+                for(size_t n = 0; n < active.size(); ++n){
+                    if(map[n] >= 0){
+                        kept.push_back(active[n]);
+                    } else {
+                        // release the pyramids
+                        leftPyr[active[n]].clear();
+                        rightPyr[active[n]].clear();
+                    }
+                }
+                if(kept.size() < active.size()){
+                    remapExemplars(*knnf, map);
+                    active.swap(kept);
+                }
+            }
+            coarse = knnf;
+        }
+        if(usage){
+            usage->exemplars += source.memory() + peak;
+        }
+        return pyrCollapse(result);
+    }
+
+    /**
+     * \brief Multi-scale synthesis over the query and exemplar pyramids
+     *
+     * By default, each level is synthesized independently. With
+     * params.incremental, each k-NNF starts from the upsampled one of the
+     * previous level. With params.pruneThreshold, the exemplars used by
+     * less than that share of the k-NNF entries are dropped for the finer
+     * levels. If the threshold cannot keep all of them, only the coarsest
+     * level of the exemplar pyramids is computed (by gaussian reductions)
+     * before that decision, and the kept exemplars are then loaded again to
+     * build their full pyramids.
+     * The laplacian result is collapsed. For gaussian pyramids, only the
+     * finest level is synthesized (as stereo_synth.m does).
+     *
+     * \param usage
+     *          if not NULL, it gets the memory of the fields and images
+     *          (@see planSynthesis in synth_plan.h for the prediction)
+     */
+    inline Image synthesize(const Image &query, const ExemplarSource &source, const SynthParams &params,
+            SynthFootprint *usage = NULL) {
+        switch(params.k){
+            case 3: return synthesize<3>(query, source, params, usage);
+            case 5: return synthesize<5>(query, source, params, usage);
+            case 9: return synthesize<9>(query, source, params, usage);
+            default:
+                assert(params.k == SYNTH_K && "Synthesis with a k that is not compiled (see synthKValues)");
+                return synthesize<SYNTH_K>(query, source, params, usage);
+        }
+    }
+
+    //! synthesis from exemplar frames in memory
+    inline Image synthesize(const Image &query, const std::vector<Image> &lefts, const std::vector<Image> &rights, const SynthParams &params,
+            SynthFootprint *usage = NULL) {
+        return synthesize(query, ExemplarImages(lefts, rights), params, usage);
+    }
+
+}
+
+#endif	/* IMPL_STEREO_SYNTH_H */
+
@@ -0,0 +1,182 @@
+/*
+ * File:   synth_plan.h
+ */
+
+#ifndef IMPL_SYNTH_PLAN_H
+#define	IMPL_SYNTH_PLAN_H
+
+#include "stereo_synth.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pm {
+
+    namespace synth {
+
+        //! memory of a float image
+        inline size_t imageMemory(double rows, double cols, int channels) {
+            return allocatedBytes(size_t(rows) * size_t(cols) * channels * sizeof(float));
+        }
+
+        //! memory of the levels of a pyramid (none without reduction, since they share the image)
+        inline size_t pyramidMemory(int rows, int cols, int channels, int levels) {
+            size_t bytes = 0;
+            for(int l = levels; l >= 0 && levels > 0; --l){
+                bytes += imageMemory(rows, cols, channels);
+                rows = (rows + 1) / 2;
+                cols = (cols + 1) / 2;
+            }
+            return bytes;
+        }
+
+        //! memory of the synthesized levels
+        inline size_t resultMemory(int rows, int cols, int channels, int levels) {
+            size_t bytes = 0;
+            for(int l = levels; l >= 0; --l){
+                bytes += imageMemory(rows, cols, channels);
+                rows = (rows + 1) / 2;
+                cols = (cols + 1) / 2;
+            }
+            return bytes;
+        }
+
+        //! memory of a field with K entries and the tracked best one (@see ix_k_nnf.h)
+        inline size_t fieldMemory(int rows, int cols, int patchSize, int K) {
+            typedef NearestNeighborField<TargetPatch, float, 1>::PatchData PatchData;
+            const size_t n = size_t(std::max(0, rows - patchSize + 1)) * std::max(0, cols - patchSize + 1);
+            return allocatedBytes(n * K * sizeof(PatchData)) + allocatedBytes(n * sizeof(PatchData));
+        }
+
+        //! memory of the memo of rejected patches (@see nnf/memo.h)
+        inline size_t memoMemory(int rows, int cols, int patchSize) {
+            const size_t n = size_t(std::max(0, rows - patchSize + 1)) * std::max(0, cols - patchSize + 1);
+            return n * PM_MEMO_SLOTS * sizeof(uint32_t);
+        }
+
+    }
+
+    /**
+     * \brief Predicted footprint of stereo_synth for a query
+     *
+     * The fields and the query pyramid are exact for the query size, while
+     * the exemplars are estimated from their average number of pixels
+     * (each pyramid level having a quarter of the pixels of the finer one).
+     * With params.pruneThreshold, only the coarsest level of all exemplars
+     * is built before the pruning, which keeps at most 1 / threshold of them
+     * (@see maxKeptExemplars): the peak is the largest of both stages
+     * (the full pyramids when all the exemplars can be kept).
+     *
+     * \param exemplarPixels
+     *          the average number of pixels of a left frame
+     * \param numExemplars
+     *          the number of exemplar gists in memory
+     * \param gistDim
+     *          the dimension of the gists (0 if they are not kept)
+     * \param framesInMemory
+     *          whether the exemplar frames are kept by the caller
+     *          (ExemplarImages), or loaded on demand
+     */
+    inline SynthFootprint predictFootprint(const SynthParams &params, int k, int targets, int rows, int cols, int channels,
+            double exemplarPixels, size_t numExemplars = 0, int gistDim = 0, bool framesInMemory = false) {
+        using namespace synth;
+        const int levels = synthLevels(params, rows, cols);
+        SynthFootprint f;
+        f.nnf = fieldMemory(rows, cols, params.patchSize, k);
+        if(!params.knnVote){
+            f.nnf += fieldMemory(rows, cols, params.patchSize, 1);
+        }
+        if(params.rejectMemo){
+            f.nnf += memoMemory(rows, cols, params.patchSize);
+        }
+        if(params.incremental && levels > 0){
+            // k-NNF of the previous level
+            f.nnf += fieldMemory((rows + 1) / 2, (cols + 1) / 2, params.patchSize, k);
+        }
+        const size_t frame = imageMemory(1, exemplarPixels, channels);
+        size_t pyramid = 0;
+        if(levels > 0){
+            for(int l = 0; l <= levels; ++l){
+                pyramid += imageMemory(1, exemplarPixels * std::pow(0.25, l), channels);
+            }
+        } else if(!framesInMemory){
+            pyramid = frame; // the single level is the loaded frame
+        }
+        size_t pyramids = size_t(targets) * 2 * pyramid;
+        if(levels > 0 && params.pruneThreshold > 0.0f){
+            const size_t coarsest = imageMemory(1, exemplarPixels * std::pow(0.25, levels), channels);
+            const int kept = std::min(targets, maxKeptExemplars(params.pruneThreshold));
+            pyramids = std::max(size_t(targets) * 2 * coarsest, size_t(kept) * 2 * pyramid);
+        }
+        f.exemplars = pyramids + (framesInMemory ? size_t(targets) * 2 * frame : 0);
+        f.query = pyramidMemory(rows, cols, channels, levels) + resultMemory(rows, cols, channels, levels);
+        f.descriptors = numExemplars * gistDim * sizeof(float);
+        return f;
+    }
+
+    /**
+     * \brief Choice of k and of the number of exemplars for a memory budget
+     */
+    struct SynthPlan {
+        int k;                      //!< number of k-NNF entries
+        int targets;                //!< number of exemplars
+        SynthFootprint footprint;   //!< predicted footprint
+        bool fits;                  //!< whether the footprint is within the budget
+    };
+
+    /**
+     * \brief Plan a synthesis within params.budget bytes
+     *
+     * The exemplars come first up to params.minTargets, then the largest
+     * compiled k that still fits, and finally as many exemplars as the
+     * remaining budget allows (up to params.targets if fixed).
+     * If nothing fits, the smallest k with params.minTargets exemplars is
+     * returned with fits = false.
+     * Without budget, k is params.k and the exemplars come from targetNumber.
+     *
+     * \param framesInMemory
+     *          whether the exemplar frames are kept by the caller (@see predictFootprint)
+     */
+    inline SynthPlan planSynthesis(const SynthParams &params, size_t numExemplars, int rows, int cols, int channels,
+            double exemplarPixels, int gistDim = 0, bool framesInMemory = false) {
+        const int maxTargets = params.targets > 0 ? std::min<int>(params.targets, numExemplars) : int(numExemplars);
+        const int minTargets = std::min(params.minTargets, maxTargets);
+        SynthPlan plan;
+        plan.fits = true;
+        if(params.budget <= 0.0){
+            plan.k = params.k;
+            plan.targets = targetNumber(params, numExemplars, exemplarPixels);
+            plan.footprint = predictFootprint(params, plan.k, plan.targets, rows, cols, channels, exemplarPixels, numExemplars, gistDim, framesInMemory);
+            return plan;
+        }
+        const std::vector<int> &values = synthKValues();
+        for(auto it = values.rbegin(); it != values.rend(); ++it){
+            // largest number of exemplars within the budget (the footprint grows with it)
+            int lo = 0, hi = maxTargets;
+            while(lo < hi){
+                const int mid = (lo + hi + 1) / 2;
+                SynthFootprint f = predictFootprint(params, *it, mid, rows, cols, channels, exemplarPixels, numExemplars, gistDim, framesInMemory);
+                if(double(f.total()) <= params.budget){
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            if(lo >= std::max(1, minTargets)){
+                plan.k = *it;
+                plan.targets = lo;
+                plan.footprint = predictFootprint(params, plan.k, plan.targets, rows, cols, channels, exemplarPixels, numExemplars, gistDim, framesInMemory);
+                return plan;
+            }
+        }
+        plan.k = values.front();
+        plan.targets = std::max(1, minTargets);
+        plan.footprint = predictFootprint(params, plan.k, plan.targets, rows, cols, channels, exemplarPixels, numExemplars, gistDim, framesInMemory);
+        plan.fits = false;
+        return plan;
+    }
+
+}
+
+#endif	/* IMPL_SYNTH_PLAN_H */
+
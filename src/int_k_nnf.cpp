@@ -12,8 +12,10 @@
 #endif
 
 #include "impl/int_k_nnf.h"
+#include "io/telemetry.h"
 #include "nnf/algorithm.h"
 #include "nnf/propagation.h"
+#include "nnf/region.h"
 #include "nnf/uniformsearch.h"
 #include "scanline.h"
 
@@ -28,6 +30,22 @@ typedef Distance<Patch2ti, float> DistanceFunc;
  * Usage:
  * 
  * [newNNF, conv] = iknnf( source, target, prevNNF, options )
+ *
+ * With options.telemetry = 'path', the convergence of each iteration is
+ * appended to the file (options.telemetry_format = 'json' lines or 'csv').
+ * A warning is raised if the file cannot be written.
+ *
+ * With options.reject_memo = true, each pixel remembers the patches it
+ * rejected or evicted, and skips their distance in the next iterations.
+ * The patches are remembered by a 32-bit hash: a colliding candidate is
+ * silently skipped, even if it would have improved the result.
+ *
+ * Incremental update of prevNNF after local changes of the source:
+ * options.dirty is a mask of the changed source pixels, or
+ * options.dirty_rects a N x 4 matrix of [x y w h] rectangles.
+ * The patches overlapping these pixels are re-initialized, and the search
+ * only runs around them (options.halo pixels, patch_size by default).
+ * The rest of prevNNF is left untouched.
  */
 void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // checking the input
@@ -69,8 +87,39 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // create algorithm sequence
     auto seq = Algorithm() << UniformSearch<Patch2ti, float, KNNF_K>(&nnf) << Propagation<Patch2ti, float, KNNF_K>(&nnf);
     
+    // region of an incremental update
+    bool incremental = options.has("dirty") || options.has("dirty_rects");
+    Mask dirty;
+    if(incremental){
+        if(nin < 3 || mxGetNumberOfElements(in[2]) == 0){
+            mexErrMsgIdAndTxt("MATLAB:nnf:missingNNF", "Incremental update requires a previous nnf!");
+        }
+        dirty = options.has("dirty") ? options.image("dirty") : rectMask(source.height, source.width, options.rects("dirty_rects"));
+        if(dirty.width != source.width || dirty.height != source.height){
+            mexErrMsgIdAndTxt("MATLAB:nnf:invalidMask", "The dirty mask must have the size of the source!");
+        }
+    }
+    
     // scanline with the sequence of algorithm
-    scanline(nnf, numIter, seq);
+    const std::string telemetryPath = options.string("telemetry", "");
+    TelemetryPtr sink = createTelemetry(telemetryPath, options.string("telemetry_format", "json"));
+    if(!telemetryPath.empty() && !sink){
+        mexWarnMsgIdAndTxt("MATLAB:nnf:telemetry", "Cannot write the telemetry to %s, it is disabled.", telemetryPath.c_str());
+    }
+    TelemetryIteration<NNF> telemetry(sink.get(), "iknnf", &nnf);
+    auto counted = telemetry.count(seq);
+    const bool useMemo = options.boolean("reject_memo", false);
+    RejectMemo memo(useMemo ? nnf.width : 0, nnf.height); // empty if unused
+    if(useMemo){
+        nnf.memo = &memo;
+    }
+    if(incremental){
+        scanlineRegion(nnf, dirty, options.integer("halo", patchSize), numIter, counted, telemetry);
+    } else {
+        NoOp<Point2i> filter;
+        scanline(nnf, numIter, counted, filter, telemetry);
+    }
+    nnf.memo = NULL;
     
     // save nnf and output it
     if(nout > 0){
@@ -27,7 +27,7 @@ namespace pm {
         
         Image compute() const{
             PixelContainer<channels, Patch2ti, float, 1> data(nnf);
-            return weighted_average(data, *filter);
+            return scatter_average(data, *filter);
         }
 
         VoteOperation(const VoteOperation<channels-1> &v) :  nnf(v.nnf), filter(v.filter) {}
@@ -0,0 +1,352 @@
+/*
+ * File:   cache.h
+ */
+
+#ifndef IO_CACHE_H
+#define	IO_CACHE_H
+
+#include "../math/imageset.h"
+#include "../math/mat.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/shared_ptr.hpp>
+
+namespace pm {
+
+    /**
+     * \brief Binary cache container (one file per exemplar)
+     *
+     * File layout (little-endian):
+     *  - CacheHeader
+     *  - CachePlane[planes] table of contents
+     *  - the planes, each starting at an offset multiple of the alignment
+     *
+     * Each plane is the raw content of a Mat (contiguous row-major rows of
+     * interleaved channels), so that it can be used from the mapped file
+     * without any copy or transposition. The planes are identified by a name
+     * (e.g. "image", "right", "uv", "gist", "nnf") and a pyramid level.
+     *
+     * @see toolbox/load_cache.m
+     */
+    struct CacheHeader {
+        char magic[4];          // "PMCF"
+        uint32_t version;
+        uint32_t planes;
+        uint32_t alignment;
+    };
+
+    struct CachePlane {
+        char name[16];
+        int32_t level;
+        int32_t rows;
+        int32_t cols;
+        int32_t type;           // Mat::type()
+        uint32_t elemSize;      // Mat::elemSize()
+        uint32_t reserved;
+        uint64_t offset;        // from the start of the file
+
+        inline uint64_t bytes() const {
+            return uint64_t(rows) * cols * elemSize;
+        }
+        inline bool is(const std::string &n, int l) const {
+            return level == l && std::strncmp(name, n.c_str(), sizeof(name)) == 0;
+        }
+    };
+
+    enum {
+        CacheVersion = 1,
+        CacheAlignment = 64
+    };
+
+    /**
+     * \brief Cache file writer
+     */
+    class CacheWriter {
+    public:
+
+        /**
+         * \brief Add a plane (the data is not copied until save)
+         *
+         * Column-major or non-contiguous matrices (e.g. Matlab views) are
+         * first copied into contiguous row-major rows.
+         */
+        void add(const std::string &name, int level, const Mat &m) {
+            assert(name.size() < sizeof(CachePlane().name) && "Cache plane name is too long");
+            assert(!m.empty() && "Caching an empty matrix");
+            CachePlane p;
+            std::memset(&p, 0, sizeof(p));
+            std::strncpy(p.name, name.c_str(), sizeof(p.name) - 1);
+            p.level = level;
+            p.rows = m.rows;
+            p.cols = m.cols;
+            p.type = m.type();
+            p.elemSize = m.elemSize();
+            planes.push_back(p);
+            data.push_back(m.contiguous());
+        }
+
+        bool save(const std::string &fname) const {
+            std::ofstream out(fname.c_str(), std::ios::binary);
+            if(!out) return false;
+            CacheHeader header = { { 'P', 'M', 'C', 'F' }, CacheVersion, uint32_t(planes.size()), CacheAlignment };
+            // table of contents with aligned offsets
+            std::vector<CachePlane> toc(planes);
+            uint64_t offset = aligned(sizeof(CacheHeader) + toc.size() * sizeof(CachePlane));
+            for(CachePlane &p : toc){
+                p.offset = offset;
+                offset = aligned(offset + p.bytes());
+            }
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            if(!toc.empty()){
+                out.write(reinterpret_cast<const char *>(&toc[0]), toc.size() * sizeof(CachePlane));
+            }
+            for(size_t i = 0; i < toc.size(); ++i){
+                pad(out, toc[i].offset);
+                Mat m = data[i];
+                out.write(reinterpret_cast<const char *>(m.ptr()), toc[i].bytes());
+            }
+            return bool(out);
+        }
+
+        inline size_t size() const {
+            return planes.size();
+        }
+
+    private:
+
+        static uint64_t aligned(uint64_t offset) {
+            return (offset + CacheAlignment - 1) / CacheAlignment * CacheAlignment;
+        }
+
+        static void pad(std::ofstream &out, uint64_t offset) {
+            static const char zeros[CacheAlignment] = { 0 };
+            uint64_t pos = out.tellp();
+            assert(pos <= offset && "Invalid cache plane offset");
+            out.write(zeros, offset - pos);
+        }
+
+        std::vector<CachePlane> planes;
+        std::vector<Mat> data;
+    };
+
+    /**
+     * \brief Memory-mapped cache file
+     *
+     * The file is mapped privately: the matrices returned by get() point
+     * directly into the mapping and can be modified (copy-on-write) without
+     * changing the file. The mapping stays alive as long as any of them does.
+     */
+    class CacheFile {
+    public:
+
+        CacheFile() {}
+
+        explicit CacheFile(const std::string &fname) {
+            open(fname);
+        }
+
+        bool open(const std::string &fname) {
+            map.reset();
+            planes.clear();
+            int fd = ::open(fname.c_str(), O_RDONLY);
+            if(fd < 0) return false;
+            struct stat st;
+            if(fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(CacheHeader)){
+                ::close(fd);
+                return false;
+            }
+            void *addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if(addr == MAP_FAILED) return false;
+            map.reset(new Mapping(reinterpret_cast<byte *>(addr), st.st_size));
+
+            // check header and table of contents
+            const CacheHeader *header = reinterpret_cast<const CacheHeader *>(map->addr);
+            const uint64_t tocEnd = sizeof(CacheHeader) + uint64_t(header->planes) * sizeof(CachePlane);
+            if(std::strncmp(header->magic, "PMCF", 4) != 0 || header->version != CacheVersion || tocEnd > map->size){
+                map.reset();
+                return false;
+            }
+            const CachePlane *toc = reinterpret_cast<const CachePlane *>(map->addr + sizeof(CacheHeader));
+            planes.assign(toc, toc + header->planes);
+            for(const CachePlane &p : planes){
+                if(!valid(p, map->size)){
+                    map.reset();
+                    planes.clear();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        inline bool isOpen() const {
+            return bool(map);
+        }
+
+        inline const std::vector<CachePlane> &contents() const {
+            return planes;
+        }
+
+        inline bool has(const std::string &name, int level) const {
+            return find(name, level) >= 0;
+        }
+
+        /**
+         * \brief Get a plane as a matrix pointing into the mapped file
+         *
+         * \return the matrix, or an empty one if the plane is not found
+         */
+        Mat get(const std::string &name, int level) const {
+            int i = find(name, level);
+            if(i < 0) return Mat();
+            const CachePlane &p = planes[i];
+            DataPtr ptr(map->addr + p.offset, Reference(map));
+            return Mat(p.rows, p.cols, p.type, p.elemSize, ptr);
+        }
+
+        //! number of consecutive levels of a plane (starting at level 1)
+        int levels(const std::string &name) const {
+            int l = 0;
+            while(has(name, l + 1)) ++l;
+            return l;
+        }
+
+    private:
+
+        struct Mapping {
+            byte *addr;
+            size_t size;
+
+            Mapping(byte *a, size_t s) : addr(a), size(s) {}
+            ~Mapping() {
+                munmap(addr, size);
+            }
+        };
+        typedef boost::shared_ptr<Mapping> MappingPtr;
+
+        //! fake deleter that keeps the mapping alive
+        struct Reference {
+            MappingPtr map;
+
+            explicit Reference(const MappingPtr &m) : map(m) {}
+            void operator()(byte *) {
+                map.reset();
+            }
+        };
+
+        /**
+         * \brief Whether a plane header describes a matrix within the file
+         *
+         * The sizes are checked without overflow, the name must be
+         * null-terminated and standard depths must have their element size.
+         */
+        static bool valid(const CachePlane &p, uint64_t fileSize) {
+            if(!std::memchr(p.name, 0, sizeof(p.name)) || p.rows < 0 || p.cols < 0 || p.elemSize == 0){
+                return false;
+            }
+            const int depth = IM_MAT_DEPTH(p.type);
+            if(p.type != IM_MAT_TYPE(p.type) || (depth > IM_64F && depth != IM_USRTYPE)
+                    || (depth != IM_USRTYPE && p.elemSize != uint32_t(IM_SIZEOF(p.type)))){
+                return false;
+            }
+            // the row steps of a Mat are int
+            const uint64_t rowBytes = uint64_t(p.cols) * p.elemSize;
+            if(rowBytes > uint64_t(std::numeric_limits<int>::max())){
+                return false;
+            }
+            if(p.offset % CacheAlignment != 0 || p.offset > fileSize){
+                return false;
+            }
+            return p.rows == 0 || rowBytes <= (fileSize - p.offset) / uint64_t(p.rows);
+        }
+
+        int find(const std::string &name, int level) const {
+            for(size_t i = 0; i < planes.size(); ++i){
+                if(planes[i].is(name, level)) return i;
+            }
+            return -1;
+        }
+
+        MappingPtr map;
+        std::vector<CachePlane> planes;
+    };
+
+    /**
+     * \brief Add or replace one plane of a cache file, keeping the others
+     *
+     * The new file is written aside then renamed over the original, so that
+     * the mappings of the previous file (CacheFile, mxCachedImage) stay valid.
+     *
+     * \return false if the file exists but is not a cache file,
+     *         or if it cannot be written
+     */
+    inline bool updateCache(const std::string &fname, const std::string &name, int level, const Mat &m) {
+        CacheWriter writer;
+        struct stat st;
+        if(stat(fname.c_str(), &st) == 0){
+            CacheFile cache(fname);
+            if(!cache.isOpen()) return false; // not ours to overwrite
+            for(const CachePlane &p : cache.contents()){
+                // the plane names are null-terminated (see CacheWriter::add)
+                if(!p.is(name, level)){
+                    writer.add(p.name, p.level, cache.get(p.name, p.level));
+                }
+            }
+        }
+        writer.add(name, level, m);
+        const std::string tmp = fname + ".tmp";
+        if(!writer.save(tmp) || std::rename(tmp.c_str(), fname.c_str()) != 0){
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * \brief Parse a cache plane reference "file.pmc:level" (level 1 by default)
+     */
+    inline void parseCacheSpec(const std::string &spec, std::string *file, int *level) {
+        size_t sep = spec.find_last_of(':');
+        if(sep != std::string::npos && sep + 1 < spec.size()
+                && spec.find_first_not_of("0123456789", sep + 1) == std::string::npos){
+            *file = spec.substr(0, sep);
+            *level = std::atoi(spec.c_str() + sep + 1);
+        } else {
+            *file = spec;
+            *level = 1;
+        }
+    }
+
+    /**
+     * \brief Map the same plane of a list of cache files into an image set
+     *
+     * \return whether all the planes were found
+     */
+    inline bool loadImageSet(const std::vector<std::string> &files, const std::string &name, int level, ImageSet *set) {
+        ImageSet res(files.size());
+        for(size_t i = 0; i < files.size(); ++i){
+            CacheFile cache(files[i]);
+            res[i] = cache.get(name, level);
+            if(res[i].empty()) return false;
+        }
+        *set = res;
+        return true;
+    }
+
+}
+
+#endif	/* IO_CACHE_H */
+
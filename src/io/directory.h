@@ -0,0 +1,88 @@
+/*
+ * File:   directory.h
+ */
+
+#ifndef IO_DIRECTORY_H
+#define	IO_DIRECTORY_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace pm {
+
+    namespace path {
+
+        inline std::string join(const std::string &dir, const std::string &name) {
+            if(dir.empty() || dir[dir.size() - 1] == '/'){
+                return dir + name;
+            }
+            return dir + "/" + name;
+        }
+
+        //! file name without directory nor extension (as fileparts in Matlab)
+        inline std::string stem(const std::string &file) {
+            size_t start = file.find_last_of('/');
+            start = start == std::string::npos ? 0 : start + 1;
+            size_t end = file.find_last_of('.');
+            if(end == std::string::npos || end < start){
+                end = file.size();
+            }
+            return file.substr(start, end - start);
+        }
+
+        inline bool endsWith(const std::string &str, const std::string &suffix) {
+            return str.size() >= suffix.size()
+                && std::equal(suffix.rbegin(), suffix.rend(), str.rbegin());
+        }
+
+        inline bool isDirectory(const std::string &p) {
+            struct stat st;
+            return stat(p.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        }
+
+        inline bool exists(const std::string &p) {
+            struct stat st;
+            return stat(p.c_str(), &st) == 0;
+        }
+
+        //! create a directory and its parents (as mkdir -p)
+        inline bool makeDirectories(const std::string &p) {
+            if(p.empty() || isDirectory(p)) return true;
+            size_t parent = p.find_last_of('/', p.size() - 2);
+            if(parent != std::string::npos && parent > 0){
+                makeDirectories(p.substr(0, parent));
+            }
+            return mkdir(p.c_str(), 0755) == 0 || isDirectory(p);
+        }
+    }
+
+    /**
+     * \brief List the image files of a directory (sorted by name)
+     *
+     * @see toolbox/find_images.m
+     */
+    inline std::vector<std::string> findImages(const std::string &dir, const std::string &ext = ".png") {
+        std::vector<std::string> files;
+        DIR *d = opendir(dir.c_str());
+        if(!d) return files;
+        while(struct dirent *entry = readdir(d)){
+            std::string name(entry->d_name);
+            if(name.empty() || name[0] == '.') continue;
+            std::string file = path::join(dir, name);
+            if(path::endsWith(name, ext) && !path::isDirectory(file)){
+                files.push_back(file);
+            }
+        }
+        closedir(d);
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+}
+
+#endif	/* IO_DIRECTORY_H */
+
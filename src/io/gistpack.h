@@ -0,0 +1,114 @@
+/*
+ * File:   gistpack.h
+ */
+
+#ifndef IO_GISTPACK_H
+#define	IO_GISTPACK_H
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace pm {
+
+    /**
+     * Packed gist descriptors of an exemplar collection
+     *
+     * File layout (little-endian):
+     *  - char[4]   magic "GSTP"
+     *  - uint32    version
+     *  - uint32    number of exemplars N
+     *  - uint32    descriptor dimension D
+     *  - uint32    number of channels per descriptor
+     *  - N x (uint32 length, char[length]) exemplar names
+     *  - float32[N * D] descriptors (one row per exemplar)
+     *
+     * @see toolbox/load_gist_pack.m
+     */
+    struct GistPack {
+
+        enum {
+            version = 1
+        };
+
+        uint32_t channels;
+        uint32_t dimension;
+        std::vector<std::string> names;
+        std::vector<float> data;
+
+        GistPack() : channels(0), dimension(0) {}
+        GistPack(size_t n, uint32_t dim, uint32_t ch) : channels(ch), dimension(dim), names(n), data(n * dim, 0.0f) {}
+
+        inline size_t size() const {
+            return names.size();
+        }
+        inline float *row(size_t i) {
+            return &data[i * dimension];
+        }
+        inline const float *row(size_t i) const {
+            return &data[i * dimension];
+        }
+
+        //! keep only the valid rows (e.g. drop the images that failed)
+        void keep(const std::vector<bool> &valid) {
+            size_t n = 0;
+            for(size_t i = 0; i < names.size(); ++i){
+                if(!valid[i]) continue;
+                if(n != i){
+                    names[n] = names[i];
+                    std::copy(row(i), row(i) + dimension, row(n));
+                }
+                ++n;
+            }
+            names.resize(n);
+            data.resize(n * dimension);
+        }
+
+        bool save(const std::string &fname) const {
+            std::ofstream out(fname.c_str(), std::ios::binary);
+            if(!out) return false;
+            uint32_t header[4] = { version, uint32_t(names.size()), dimension, channels };
+            out.write("GSTP", 4);
+            out.write(reinterpret_cast<const char *>(header), sizeof(header));
+            for(const std::string &name : names){
+                uint32_t len = name.size();
+                out.write(reinterpret_cast<const char *>(&len), sizeof(len));
+                out.write(name.data(), len);
+            }
+            if(!data.empty()){
+                out.write(reinterpret_cast<const char *>(&data[0]), data.size() * sizeof(float));
+            }
+            return bool(out);
+        }
+
+        bool load(const std::string &fname) {
+            std::ifstream in(fname.c_str(), std::ios::binary);
+            char magic[4];
+            uint32_t header[4];
+            if(!in.read(magic, 4) || std::string(magic, 4) != "GSTP") return false;
+            if(!in.read(reinterpret_cast<char *>(header), sizeof(header))) return false;
+            if(header[0] != version) return false;
+            names.resize(header[1]);
+            dimension = header[2];
+            channels = header[3];
+            for(std::string &name : names){
+                uint32_t len = 0;
+                in.read(reinterpret_cast<char *>(&len), sizeof(len));
+                name.resize(len);
+                if(len > 0) in.read(&name[0], len);
+            }
+            data.resize(names.size() * dimension);
+            if(!data.empty()){
+                in.read(reinterpret_cast<char *>(&data[0]), data.size() * sizeof(float));
+            }
+            return bool(in);
+        }
+    };
+
+}
+
+#endif	/* IO_GISTPACK_H */
+
@@ -0,0 +1,126 @@
+/*
+ * File:   matfile.h
+ */
+
+#ifndef IO_MATFILE_H
+#define	IO_MATFILE_H
+
+#include "../math/mat.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace pm {
+
+    namespace matfile {
+
+        enum DataType {
+            miINT8 = 1,
+            miINT32 = 5,
+            miUINT32 = 6,
+            miDOUBLE = 9,
+            miMATRIX = 14
+        };
+
+        enum ClassType {
+            mxDOUBLE = 6
+        };
+
+        inline uint32_t padded(uint32_t bytes) {
+            return (bytes + 7) & ~7u;
+        }
+
+        inline void writeTag(std::ofstream &out, uint32_t type, uint32_t bytes) {
+            uint32_t tag[2] = { type, bytes };
+            out.write(reinterpret_cast<const char *>(tag), sizeof(tag));
+        }
+
+        inline void writePadding(std::ofstream &out, uint32_t bytes) {
+            static const char zeros[8] = { 0 };
+            out.write(zeros, padded(bytes) - bytes);
+        }
+
+    }
+
+    /**
+     * \brief Save a float image as a Matlab (v5, uncompressed) mat file
+     *
+     * The image is stored as a double array in a single variable, so that
+     * the file is interchangeable with the ones of toolbox/save_mat.m
+     * (and readable with load_mat.m).
+     *
+     * \param fname
+     *          the mat file name
+     * \param img
+     *          the float image (IM_32FC(n))
+     * \param varName
+     *          the name of the variable
+     * \return whether the file was written
+     */
+    inline bool saveMat(const std::string &fname, const Image &img, const std::string &varName = "data") {
+        using namespace matfile;
+        assert(img.depth() == IM_32F && "Only float images can be saved");
+        std::ofstream out(fname.c_str(), std::ios::binary);
+        if(!out) return false;
+
+        // 128 bytes header
+        char header[128];
+        std::memset(header, ' ', 116);
+        const char *text = "MATLAB 5.0 MAT-file, Platform: GLNXA64, Created by: stereosynth";
+        std::memcpy(header, text, std::strlen(text));
+        std::memset(header + 116, 0, 8);
+        uint16_t version = 0x0100;
+        std::memcpy(header + 124, &version, 2);
+        header[126] = 'I';
+        header[127] = 'M';
+        out.write(header, sizeof(header));
+
+        // dimensions
+        const int C = img.channels();
+        std::vector<int32_t> dims;
+        dims.push_back(img.rows);
+        dims.push_back(img.cols);
+        if(C > 1) dims.push_back(C);
+        const uint32_t dimBytes = dims.size() * sizeof(int32_t);
+        const uint32_t nameBytes = varName.size();
+        const uint32_t dataBytes = uint32_t(img.rows) * img.cols * C * sizeof(double);
+        const uint32_t total = 8 + 8 // array flags
+                             + 8 + padded(dimBytes)
+                             + 8 + padded(nameBytes)
+                             + 8 + dataBytes;
+        writeTag(out, miMATRIX, total);
+
+        // array flags
+        uint32_t flags[2] = { mxDOUBLE, 0 };
+        writeTag(out, miUINT32, sizeof(flags));
+        out.write(reinterpret_cast<const char *>(flags), sizeof(flags));
+        // dimensions
+        writeTag(out, miINT32, dimBytes);
+        out.write(reinterpret_cast<const char *>(&dims[0]), dimBytes);
+        writePadding(out, dimBytes);
+        // name
+        writeTag(out, miINT8, nameBytes);
+        out.write(varName.data(), nameBytes);
+        writePadding(out, nameBytes);
+        // column-major data
+        writeTag(out, miDOUBLE, dataBytes);
+        std::vector<double> column(img.rows);
+        for(int c = 0; c < C; ++c){
+            for(int x = 0; x < img.cols; ++x){
+                for(int y = 0; y < img.rows; ++y){
+                    column[y] = img.ptr<float>(y, x)[c];
+                }
+                out.write(reinterpret_cast<const char *>(&column[0]), column.size() * sizeof(double));
+            }
+        }
+        return bool(out);
+    }
+
+}
+
+#endif	/* IO_MATFILE_H */
+
@@ -0,0 +1,85 @@
+/*
+ * File:   png.h
+ */
+
+#ifndef IO_PNG_H
+#define	IO_PNG_H
+
+#include "../math/mat.h"
+#include "../math/vec.h"
+
+// png++
+#include <cstring>
+#include "../../libs/pngpp/png.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <string>
+
+namespace pm {
+
+    /**
+     * \brief Load a png file as a float RGB image with values in [0;1]
+     *
+     * Throws png::error if the file cannot be read.
+     */
+    inline Image loadPNG(const std::string &fname) {
+        png::image<png::rgb_pixel> img(fname);
+        const float maxVal = std::numeric_limits<png::byte>::max();
+        Image m(img.get_height(), img.get_width(), IM_32FC3);
+        for(int y = 0; y < m.rows; ++y){
+            const png::image<png::rgb_pixel>::row_type &row = img.get_row(y);
+            for(int x = 0; x < m.cols; ++x){
+                Vec3f &v = m.at<Vec3f>(y, x);
+                const png::rgb_pixel &p = row[x];
+                v[0] = p.red    / maxVal;
+                v[1] = p.green  / maxVal;
+                v[2] = p.blue   / maxVal;
+            }
+        }
+        return m;
+    }
+
+    /**
+     * \brief Size of a png file from its header only (no decoding)
+     *
+     * Throws png::error if the header cannot be read.
+     */
+    inline void readPNGSize(const std::string &fname, int *rows, int *cols) {
+        std::ifstream stream(fname.c_str(), std::ios::binary);
+        if(!stream){
+            throw png::std_error(fname);
+        }
+        png::reader<std::istream> reader(stream);
+        reader.read_info();
+        *rows = reader.get_height();
+        *cols = reader.get_width();
+    }
+
+    /**
+     * \brief Save a float image (1 or 3 channels, values in [0;1]) as png
+     */
+    inline void savePNG(const std::string &fname, const Image &m) {
+        assert(m.depth() == IM_32F && "Only float images can be saved");
+        const float maxVal = std::numeric_limits<png::byte>::max();
+        const int ch = m.channels();
+        png::image<png::rgb_pixel> img(m.cols, m.rows);
+        for(int y = 0; y < m.rows; ++y){
+            for(int x = 0; x < m.cols; ++x){
+                const float *v = m.ptr<float>(y, x);
+                png::byte rgb[3];
+                for(int c = 0; c < 3; ++c){
+                    float f = v[std::min(c, ch - 1)];
+                    rgb[c] = png::byte(std::max(0.0f, std::min(1.0f, f)) * maxVal + 0.5f);
+                }
+                img.set_pixel(x, y, png::rgb_pixel(rgb[0], rgb[1], rgb[2]));
+            }
+        }
+        img.write(fname);
+    }
+
+}
+
+#endif	/* IO_PNG_H */
+
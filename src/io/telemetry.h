@@ -0,0 +1,203 @@
+/*
+ * File:   telemetry.h
+ */
+
+#ifndef IO_TELEMETRY_H
+#define	IO_TELEMETRY_H
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <boost/shared_ptr.hpp>
+
+namespace pm {
+
+    /**
+     * \brief Convergence state after one scanline iteration
+     */
+    struct TelemetryRecord {
+        std::string engine;
+        int iteration;
+        double meanDist;    //!< mean of the valid k-NNF distances
+        double maxDist;     //!< maximum of the valid k-NNF distances
+        size_t updates;     //!< successful updates during the iteration
+        double seconds;     //!< duration of the iteration
+        size_t memory;      //!< resident memory (bytes)
+
+        TelemetryRecord() : iteration(0), meanDist(0), maxDist(0), updates(0), seconds(0), memory(0) {}
+    };
+
+    /**
+     * \brief Destination of the convergence records
+     */
+    class TelemetrySink {
+    public:
+        virtual ~TelemetrySink() {}
+        virtual void record(const TelemetryRecord &r) = 0;
+    };
+
+    /**
+     * \brief File sink writing JSON lines or CSV (one record per line)
+     *
+     * Records are appended, so that multiple queries can share the same file.
+     */
+    class TelemetryFile : public TelemetrySink {
+    public:
+        enum Format {
+            JSON,
+            CSV
+        };
+
+        TelemetryFile(const std::string &path, Format f = JSON) : format(f) {
+            bool header = f == CSV && !std::ifstream(path.c_str()).good();
+            out.open(path.c_str(), std::ios::out | std::ios::app);
+            if(header && out){
+                out << "engine,iteration,mean_dist,max_dist,updates,seconds,memory\n";
+            }
+        }
+
+        bool good() const {
+            return bool(out);
+        }
+
+        virtual void record(const TelemetryRecord &r) {
+            if(format == JSON){
+                out << "{\"engine\": \"" << r.engine << "\", \"iteration\": " << r.iteration
+                    << ", \"mean_dist\": " << r.meanDist << ", \"max_dist\": " << r.maxDist
+                    << ", \"updates\": " << r.updates << ", \"seconds\": " << r.seconds
+                    << ", \"memory\": " << r.memory << "}\n";
+            } else {
+                out << r.engine << "," << r.iteration << "," << r.meanDist << "," << r.maxDist << ","
+                    << r.updates << "," << r.seconds << "," << r.memory << "\n";
+            }
+            out.flush();
+        }
+
+    private:
+        std::ofstream out;
+        Format format;
+    };
+
+    typedef boost::shared_ptr<TelemetrySink> TelemetryPtr;
+
+    /**
+     * \brief File sink from a path and a format name ('json' or 'csv')
+     *
+     * \return an empty pointer if the path is empty (no telemetry)
+     *         or if the file cannot be written (the caller reports it)
+     */
+    inline TelemetryPtr createTelemetry(const std::string &path, const std::string &format = "json") {
+        if(path.empty()){
+            return TelemetryPtr();
+        }
+        TelemetryFile *file = new TelemetryFile(path, format == "csv" ? TelemetryFile::CSV : TelemetryFile::JSON);
+        if(!file->good()){
+            delete file;
+            return TelemetryPtr();
+        }
+        return TelemetryPtr(file);
+    }
+
+    //! resident memory of the process (0 if unknown)
+    inline size_t residentMemory() {
+        std::ifstream statm("/proc/self/statm");
+        size_t pages, resident;
+        if(statm >> pages >> resident){
+            return resident * size_t(sysconf(_SC_PAGESIZE));
+        }
+        // peak instead
+        struct rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage) == 0){
+            return size_t(usage.ru_maxrss) * 1024;
+        }
+        return 0;
+    }
+
+    /**
+     * \brief Algorithm wrapper counting the successful updates
+     */
+    template <typename Algo>
+    struct CountedAlgorithm {
+        Algo *algo;
+        size_t *updates;
+
+        template <typename Index>
+        unsigned int operator()(const Index &i, bool rev) {
+            unsigned int c = (*algo)(i, rev);
+            *updates += c;
+            return c;
+        }
+    };
+
+    /**
+     * \brief Scanline iteration end recording the convergence of a k-NNF
+     *
+     * Usage:
+     *   TelemetryIteration<NNF> telemetry(sink, "engine", &nnf);
+     *   auto counted = telemetry.count(seq);
+     *   scanline(nnf, iters, counted, filter, telemetry);
+     *
+     * It does nothing without sink.
+     */
+    template <typename NNF>
+    struct TelemetryIteration {
+        TelemetryIteration(TelemetrySink *s, const char *name, const NNF *field)
+        : sink(s), engine(name), nnf(field), updates(0), start(std::chrono::steady_clock::now()) {}
+
+        template <typename Algo>
+        CountedAlgorithm<Algo> count(Algo &algo) {
+            CountedAlgorithm<Algo> c;
+            c.algo = &algo;
+            c.updates = &updates;
+            return c;
+        }
+
+        unsigned int operator()(int iter, bool) {
+            if(!sink){
+                return 0;
+            }
+            TelemetryRecord r;
+            r.engine = engine;
+            r.iteration = iter;
+            r.updates = updates;
+            r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            r.memory = residentMemory();
+            // distance statistics
+            size_t n = 0;
+            for(const auto &i : *nnf){
+                for(int k = 0; k < nnf->k; ++k){
+                    double d = nnf->distance(i, k);
+                    if(std::isfinite(d) && d < std::numeric_limits<float>::max()){
+                        r.meanDist += d;
+                        r.maxDist = std::max(r.maxDist, d);
+                        ++n;
+                    }
+                }
+            }
+            if(n > 0){
+                r.meanDist /= n;
+            }
+            sink->record(r);
+            // next iteration
+            updates = 0;
+            start = std::chrono::steady_clock::now();
+            return 0;
+        }
+
+    private:
+        TelemetrySink *sink;
+        std::string engine;
+        const NNF *nnf;
+        size_t updates;
+        std::chrono::steady_clock::time_point start;
+    };
+
+}
+
+#endif	/* IO_TELEMETRY_H */
@@ -12,8 +12,11 @@
 #endif
 
 #include "impl/ix_k_nnf.h"
+#include "io/telemetry.h"
+#include "matlab/database.h"
 #include "nnf/algorithm.h"
 #include "nnf/propagation.h"
+#include "nnf/region.h"
 #include "nnf/uniformsearch.h"
 #include "scanline.h"
 
@@ -29,6 +32,30 @@ typedef Distance<TargetPatch, float, ImageSet> DistanceFunc;
  * Usage:
  * 
  * [newNNF, conv] = ixknnf( source, {targets}, prevNNF, options )
+ *
+ * where targets and prevNNF can also be cache references 'file.pmc:level'
+ * and targets an ixdb handle (left images by default).
+ * A cached prevNNF can be raw or compact (8 bytes per entry, @see nnf/compact.h).
+ *
+ * With options.cache_output = 'file.pmc:level', the compact nnf is also
+ * written as the 'nnf' plane of that cache file (see toolbox/expand_nnf.m),
+ * keeping its other planes.
+ *
+ * With options.telemetry = 'path', the convergence of each iteration is
+ * appended to the file (options.telemetry_format = 'json' lines or 'csv').
+ * A warning is raised if the file cannot be written.
+ *
+ * With options.reject_memo = true, each pixel remembers the patches it
+ * rejected or evicted, and skips their distance in the next iterations.
+ * The patches are remembered by a 32-bit hash: a colliding candidate is
+ * silently skipped, even if it would have improved the result.
+ *
+ * Incremental update of prevNNF after local changes of the source:
+ * options.dirty is a mask of the changed source pixels, or
+ * options.dirty_rects a N x 4 matrix of [x y w h] rectangles.
+ * The patches overlapping these pixels are re-initialized, and the search
+ * only runs around them (options.halo pixels, patch_size by default).
+ * The rest of prevNNF is left untouched.
  */
 void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // checking the input
@@ -53,14 +80,30 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     
     // load source and target
     Image source = mxArrayToImage(in[0]);
-    ImageSet targets = mxArrayToImageSet(in[1]);
+    // the field only reads the targets by value => no copy of single images
+    ImageSet targets = mxExemplarImages(in[1], mxExemplarSet(options.field("db_set"), DB_LEFT), true);
     
     // create distance instance
     DistanceFunc d = DistanceFactory<TargetPatch, float, ImageSet>::get(dist::SSD, source.channels());
     
     // create nnf (load maybe)
     NNF nnf(source, targets, d);
-    nnf.load(nin >= 3 ? in[2] : mxCreateNothing());
+    if(nin >= 3 && mxIsChar(in[2])){
+        // mapped from a cache file
+        Mat prev = mxCachedImage(in[2], "nnf");
+        if(prev.width != nnf.width || prev.height != nnf.height){
+            mexErrMsgIdAndTxt("MATLAB:nnf:invalidCache", "Cached nnf does not match the query!");
+        }
+        if(prev.elemSize() == nnf.raw().elemSize()){
+            nnf.load(prev);
+        } else if(prev.elemSize() == sizeof(CompactEntry) * KNNF_K){
+            nnf.loadCompact(prev);
+        } else {
+            mexErrMsgIdAndTxt("MATLAB:nnf:invalidCache", "Cached nnf does not match the query!");
+        }
+    } else {
+        nnf.load(nin >= 3 ? in[2] : mxCreateNothing());
+    }
     
     // update distance (for external nnf changes)
     if(options.boolean("compute_dist", false)){
@@ -71,13 +114,60 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     auto seq = Algorithm()  << UniformSearch<TargetPatch, float, KNNF_K>(&nnf)
                             << Propagation<TargetPatch, float, KNNF_K>(&nnf);
     
+    // region of an incremental update
+    bool incremental = options.has("dirty") || options.has("dirty_rects");
+    Mask dirty;
+    if(incremental){
+        if(nin < 3 || mxGetNumberOfElements(in[2]) == 0){
+            mexErrMsgIdAndTxt("MATLAB:nnf:missingNNF", "Incremental update requires a previous nnf!");
+        }
+        dirty = options.has("dirty") ? options.image("dirty") : rectMask(source.height, source.width, options.rects("dirty_rects"));
+        if(dirty.width != source.width || dirty.height != source.height){
+            mexErrMsgIdAndTxt("MATLAB:nnf:invalidMask", "The dirty mask must have the size of the source!");
+        }
+    }
+    
     // scanline with the sequence of algorithm
-    scanline(nnf, numIter, seq);
+    const std::string telemetryPath = options.string("telemetry", "");
+    TelemetryPtr sink = createTelemetry(telemetryPath, options.string("telemetry_format", "json"));
+    if(!telemetryPath.empty() && !sink){
+        mexWarnMsgIdAndTxt("MATLAB:nnf:telemetry", "Cannot write the telemetry to %s, it is disabled.", telemetryPath.c_str());
+    }
+    TelemetryIteration<NNF> telemetry(sink.get(), "ixknnf", &nnf);
+    auto counted = telemetry.count(seq);
+    const bool useMemo = options.boolean("reject_memo", false);
+    RejectMemo memo(useMemo ? nnf.width : 0, nnf.height); // empty if unused
+    if(useMemo){
+        nnf.memo = &memo;
+    }
+    if(incremental){
+        scanlineRegion(nnf, dirty, options.integer("halo", patchSize), numIter, counted, telemetry);
+    } else {
+        NoOp<Point2i> filter;
+        scanline(nnf, numIter, counted, filter, telemetry);
+    }
+    nnf.memo = NULL;
     
     // save nnf and output it
     if(nout > 0){
         out[0] = nnf.save();
     }
+    
+    // compact copy for the next stages
+    std::string cacheOutput = options.string("cache_output", "");
+    if(!cacheOutput.empty()){
+        std::string file;
+        int level;
+        parseCacheSpec(cacheOutput, &file, &level);
+        Mat compact;
+        if(!nnf.compact(compact)){
+            mexErrMsgIdAndTxt("MATLAB:nnf:cacheOutput", "The nnf does not fit in the compact format (16-bit offsets, up to 65535 exemplars).");
+        }
+        // the other planes of the file (e.g. the exemplar pyramid) are kept
+        if(!updateCache(file, "nnf", level, compact)){
+            mexErrMsgIdAndTxt("MATLAB:nnf:cacheOutput", "Cannot write the nnf to %s", file.c_str());
+        }
+    }
 }
 
 
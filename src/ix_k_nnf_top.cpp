@@ -12,6 +12,7 @@
 #endif
 
 #include "impl/ix_k_nnf.h"
+#include "matlab/database.h"
 #include "nnf/algorithm.h"
 #include "nnf/propagation.h"
 #include "nnf/uniformsearch.h"
@@ -30,6 +31,8 @@ typedef Distance<TargetPatch, float, ImageSet> DistanceFunc;
  * Usage:
  * 
  * nnf = ixknnf_top( source, {targets}, knnf, options )
+ *
+ * where targets can also be an ixdb handle (left images by default)
  */
 void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // checking the input
@@ -53,7 +56,8 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     
     // load source and target
     Image source = mxArrayToImage(in[0]);
-    ImageSet targets = mxArrayToImageSet(in[1]);
+    // the field only reads the targets by value => no copy of single images
+    ImageSet targets = mxExemplarImages(in[1], mxExemplarSet(options.field("db_set"), DB_LEFT), true);
     
     // create distance instance
     DistanceFunc d = DistanceFactory<TargetPatch, float, ImageSet>::get(dist::SSD, source.channels());
@@ -70,16 +74,9 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // transfer data to 1-nnf
     NNF nnf(source, targets, d);
     for(const Point2i &i : knnf){
-        typename kNNF::PatchData (&p)[KNNF_K] = knnf.data.at(i);
-        int bestK = 0;
-        float bestDist = p[0].distance;
-        for(int k = 1; k < KNNF_K; ++k){
-            if(p[k].distance < bestDist){
-                bestDist = p[k].distance;
-                bestK = k;
-            }
-        }
-        nnf.store(i, p[bestK].patch, bestDist);
+        // tracked by the k-nnf upon loading
+        const kNNF::PatchData &p = knnf.top(i);
+        nnf.store(i, p.patch, p.distance);
     }
     
     // save nnf and output it
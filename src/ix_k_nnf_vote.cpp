@@ -0,0 +1,116 @@
+/*
+ * File:   ix_k_nnf_vote.cpp
+ */
+
+#define USE_MATLAB 1
+
+#ifndef SYNTH_K
+#define SYNTH_K 7
+#endif
+
+#include "impl/stereo_synth.h"
+#include "matlab/database.h"
+
+#include <boost/shared_ptr.hpp>
+
+typedef unsigned int uint;
+
+using namespace pm;
+using namespace pm::synth;
+
+/**
+ * Usage:
+ *
+ * [img, knnf, nnf] = ixknnfvote( source, {lefts}, {rights}, prevNNF, options )
+ *
+ * Fused ixknnf, ixknnf_top and ixvote: the k-NNF is computed from the source
+ * to the left images, and its best entries directly vote the right images,
+ * without marshaling the fields in between.
+ *
+ * lefts can be an ixdb handle, in which case rights can be empty
+ * (the right images of the database are used).
+ * With options.knn_vote, all the k entries vote with weights
+ * exp(-(d - dmin) / options.knn_sigma2), dmin being the best distance of the
+ * patch (default scale: mean best distance).
+ */
+void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
+    // checking the input
+	if (nin < 3 || nin > 5) {
+		mexErrMsgIdAndTxt("MATLAB:nnf:invalidNumInputs",
+				"Requires 5 arguments! (#in = %d)", nin);
+	}
+	// checking the output
+	if (nout > 3) {
+		mexErrMsgIdAndTxt("MATLAB:nnf:maxlhs",
+				"Too many output arguments.");
+	}
+
+	// options parameter
+	mxOptions options(nin >= 5 ? in[4] : mxCreateNothing());
+    int numIter = options.integer("iterations", 6);
+    int patchSize = options.integer("patch_size", 7);
+    uint algo_seed = options.scalar<uint>("rand_seed", timeSeed());
+
+    TargetPatch::width(patchSize); // set patch size
+    seed(algo_seed); // set rng state
+
+    // load source and targets
+    Image source = mxArrayToImage(in[0]);
+    ImageSet lefts = mxExemplarImages(in[1], DB_LEFT);
+    ImageSet rights;
+    if(mxIsHandle(in[1]) && mxGetNumberOfElements(in[2]) == 0){
+        rights = mxExemplarImages(in[1], DB_RIGHT);
+    } else {
+        rights = mxExemplarImages(in[2], DB_RIGHT);
+    }
+    if(rights.size() != lefts.size()){
+        mexErrMsgIdAndTxt("MATLAB:nnf:invalidTargets", "The left and right images do not match!");
+    }
+
+    // create distance instance
+    DistanceFunc d = DistanceFactory<TargetPatch, float, ImageSet>::get(dist::SSD, source.channels());
+
+    // create k-nnf (load maybe)
+    kNNF knnf(source, lefts, d);
+    knnf.load(nin >= 4 ? in[3] : mxCreateNothing());
+    if(options.boolean("compute_dist", false)){
+        knnf.update();
+    }
+
+    // k-nnf search
+    auto seq = Algorithm()  << UniformSearch<TargetPatch, float, SYNTH_K>(&knnf)
+                            << Propagation<TargetPatch, float, SYNTH_K>(&knnf);
+    scanline(knnf, numIter, seq);
+
+    // vote filter
+    Filter filter(patchSize);
+    if(options.has("vote_filter")){
+        filter.weight = options.vector("vote_filter", 1.0f, patchSize * patchSize);
+    }
+
+    // vote of the best (or all) entries from the right images
+    // (the 1-NNF is only built for the top-1 vote or as output)
+    const bool knnVote = options.boolean("knn_vote", false);
+    boost::shared_ptr<NNF> nnf;
+    if(!knnVote || nout > 2){
+        nnf.reset(new NNF(source, rights, d));
+        storeTop(knnf, nnf.get());
+    }
+    Image img;
+    if(knnVote){
+        KnnVoteOperation<1> op(&knnf, &rights, &filter, options.scalar<float>("knn_sigma2", 0.0f));
+        img = vote(op, source.channels());
+    } else {
+        VoteOperation<1> op(nnf.get(), &filter);
+        img = vote(op, source.channels());
+    }
+    if(nout > 0){
+        out[0] = mxImageToArray(img);
+    }
+    if(nout > 1){
+        out[1] = knnf.save();
+    }
+    if(nout > 2){
+        out[2] = nnf->save();
+    }
+}
@@ -7,11 +7,16 @@
 
 #define USE_MATLAB 1
 
+#ifndef KNNF_K
+#define KNNF_K 7
+#endif
+
 #include "impl/ix_k_nnf.h"
 #include "impl/ix_nnf_container.h"
 #include "math/bounds.h"
 #include "voting/weighted_average.h"
 #include "matlab.h"
+#include "matlab/database.h"
 
 using namespace pm;
 
@@ -21,29 +26,60 @@ typedef Distance<TargetPatch, float, ImageSet> DistanceFunc;
 
 namespace pm {
 
-    template <int channels = 1>
+    template <int channels>
+    Image average(const PixelContainer<channels, TargetPatch, float, 1> &data, const Filter &filter, float) {
+        return scatter_average(data, filter);
+    }
+    template <int channels, int K>
+    Image average(const PixelContainer<channels, TargetPatch, float, K> &data, const Filter &filter, float sigma2) {
+        return knn_average(data, filter, sigma2);
+    }
+
+    template <int channels = 1, int K = 1>
     struct VoteOperation {
         
-        typedef VoteOperation<channels + 1> Next;
+        typedef VoteOperation<channels + 1, K> Next;
+        typedef NearestNeighborField<TargetPatch, float, K> Field;
         
         Image compute() const{
-            PixelContainer<channels, TargetPatch, float, 1> data(nnf);
-            return weighted_average(data, *filter);
+            PixelContainer<channels, TargetPatch, float, K> data(nnf);
+            return average(data, *filter, sigma2);
         }
 
-        VoteOperation(const VoteOperation<channels-1> &v) :  nnf(v.nnf), filter(v.filter) {}
-        VoteOperation(NNF *n, Filter *f) : nnf(n), filter(f) {}
+        VoteOperation(const VoteOperation<channels-1, K> &v) :  nnf(v.nnf), filter(v.filter), sigma2(v.sigma2) {}
+        VoteOperation(Field *n, Filter *f, float s = 0.0f) : nnf(n), filter(f), sigma2(s) {}
 
-        NNF *nnf;
+        Field *nnf;
         Filter *filter;
+        float sigma2;
     };
 
+    template <int K>
+    Image fieldVote(const Image &source, const ImageSet &targets, DistanceFunc d, const mxArray *nnfArr,
+                    const mxOptions &options, Filter *filter) {
+        NearestNeighborField<TargetPatch, float, K> nnf(source, targets, d);
+        nnf.load(nnfArr);
+        
+        // update distance (for external nnf changes)
+        if(options.boolean("compute_dist", false)){
+            nnf.update();
+        }
+        
+        VoteOperation<1, K> op(&nnf, filter, options.scalar<float>("knn_sigma2", 0.0f));
+        return vote(op, source.channels());
+    }
+
 }
 
 /**
  * Usage:
  * 
  * img = ixvote( source, targets, nnf, options )
+ *
+ * where targets can also be an ixdb handle (right images by default),
+ * and nnf a k-NNF (from ixknnf) whose k entries all vote with weights
+ * exp(-(d - dmin) / options.knn_sigma2), dmin being the best distance of the
+ * patch (default scale: mean best distance)
  */
 void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // checking the input
@@ -57,9 +93,11 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
 				"Too many output arguments.");
 	}
     
+	mxOptions options(nin >= 4 ? in[3] : mxCreateNothing());
+    
     // load source and target
     Image source = mxArrayToImage(in[0]);
-    ImageSet targets = mxArrayToImageSet(in[1]);
+    ImageSet targets = mxExemplarImages(in[1], mxExemplarSet(options.field("db_set"), DB_RIGHT));
     
     // implicitly decided patch size
     MatXD nnfMat(in[2]);
@@ -69,28 +107,22 @@ void mexFunction(int nout, mxArray *out[], int nin, const mxArray *in[]) {
     // create distance instance
     DistanceFunc d = DistanceFactory<TargetPatch, float, ImageSet>::get(dist::SSD, source.channels());
     
-    // create nnf (load maybe)
-    NNF nnf(source, targets, d);
-    nnf.load(in[2]);
-    
-    // update distance (for external nnf changes)
-	mxOptions options(nin >= 4 ? in[3] : mxCreateNothing());
-    if(options.boolean("compute_dist", false)){
-        nnf.update();
-    }
-    
     // filter
     Filter filter(patchSize);
     if(options.has("vote_filter")){
         filter.weight = options.vector("vote_filter", 1.0f, patchSize * patchSize);
     }
     
-    // vote result
-    VoteOperation<1> op(&nnf, &filter);
-    Image img = vote(op, source.channels());
+    // vote result (from a 1-NNF, or all the entries of a k-NNF)
+    Image img;
+    if(nnfMat.channels() == 4 * KNNF_K){
+        img = fieldVote<KNNF_K>(source, targets, d, in[2], options, &filter);
+    } else if(nnfMat.channels() == 4){
+        img = fieldVote<1>(source, targets, d, in[2], options, &filter);
+    } else {
+        mexErrMsgIdAndTxt("MATLAB:nnf:invalidNNF", "The nnf must have 4 or %d channels!", 4 * KNNF_K);
+    }
     if(nout > 0){
         out[0] = mxImageToArray(img);
     }
 }
-
-
@@ -26,10 +26,10 @@ namespace pm {
         S bottomRatio	= p.y - y0;
         S topRatio		= S(1.0) - bottomRatio;
         // neighboring pixels
-        const T &topLeft		= img.at<T>(y0, x0);
-        const T &bottomLeft		= y1 == y0 ? topLeft : img.at<T>(y1, x0);
-        const T &topRight		= x1 == x0 ? topLeft : img.at<T>(y0, x1);
-        const T &bottomRight	= img.at<T>(y1, x1);
+        const T topLeft			= img.pixel<T>(y0, x0);
+        const T bottomLeft		= y1 == y0 ? topLeft : img.pixel<T>(y1, x0);
+        const T topRight		= x1 == x0 ? topLeft : img.pixel<T>(y0, x1);
+        const T bottomRight		= img.pixel<T>(y1, x1);
         return		topLeft		* leftRatio		* topRatio
                 +	bottomLeft	* leftRatio		* bottomRatio
                 +	topRight	* rightRatio	* topRatio
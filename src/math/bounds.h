@@ -10,6 +10,8 @@
 
 #include "vec.h"
 
+#include <vector>
+
 namespace pm {
     
     template <typename T, int numDim>
@@ -0,0 +1,203 @@
+/*
+ * File:   fft.h
+ */
+
+#ifndef MATH_FFT_H
+#define	MATH_FFT_H
+
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+namespace pm {
+
+    typedef std::complex<float> Complex;
+
+    /**
+     * Mixed-radix complex FFT of a fixed size (recursive Cooley-Tukey)
+     *
+     * The plan is immutable once created and can be shared between threads.
+     * Sizes with large prime factors still work, but degrade to O(n*p).
+     *
+     * @see http://en.wikipedia.org/wiki/Cooley%E2%80%93Tukey_FFT_algorithm
+     */
+    class FFTPlan {
+    public:
+
+        FFTPlan() : n(0), inverse(false) {}
+        explicit FFTPlan(int size, bool inv = false) : n(size), inverse(inv) {
+            assert(n > 0 && "FFT of empty size!");
+            // factorize n = p1 * p2 * ... (radix 4 first, then 2, then odd primes)
+            int m = n, p = 4;
+            while(m > 1){
+                while(m % p == 0){
+                    m /= p;
+                    factors.push_back(p);
+                    factors.push_back(m);
+                }
+                p = p == 4 ? 2 : (p == 2 ? 3 : p + 2);
+                if(p > 4 && p * p > m && m > 1){
+                    p = m; // m is prime
+                }
+            }
+            // twiddle factors
+            twiddles.resize(n);
+            const double sign = inverse ? 1.0 : -1.0;
+            for(int i = 0; i < n; ++i){
+                double phase = sign * 2.0 * M_PI * i / n;
+                twiddles[i] = Complex(std::cos(phase), std::sin(phase));
+            }
+        }
+
+        inline int size() const {
+            return n;
+        }
+
+        /**
+         * Out-of-place transform (not normalized) of n values read with a given stride
+         */
+        void transform(const Complex *in, Complex *out, int inStride = 1) const {
+            assert(in != out && "FFTPlan::transform is out-of-place");
+            if(n == 1){
+                out[0] = in[0];
+                return;
+            }
+            work(out, in, 1, inStride, &factors[0]);
+        }
+
+    private:
+
+        void work(Complex *out, const Complex *in, int fstride, int inStride, const int *f) const {
+            const int p = f[0], m = f[1];
+            Complex *outBeg = out, *outEnd = out + p * m;
+            if(m == 1){
+                do {
+                    *out = *in;
+                    in += fstride * inStride;
+                } while(++out != outEnd);
+            } else {
+                do {
+                    // recursive call on the decimated sub-sequences
+                    work(out, in, fstride * p, inStride, f + 2);
+                    in += fstride * inStride;
+                } while((out += m) != outEnd);
+            }
+            out = outBeg;
+            if(p == 2){
+                butterfly2(out, fstride, m);
+            } else if(p == 4){
+                butterfly4(out, fstride, m);
+            } else {
+                butterfly(out, fstride, m, p);
+            }
+        }
+
+        void butterfly2(Complex *out, int fstride, int m) const {
+            Complex *out2 = out + m;
+            for(int u = 0, tw = 0; u < m; ++u, tw += fstride){
+                Complex t = out2[u] * twiddles[tw];
+                out2[u] = out[u] - t;
+                out[u] += t;
+            }
+        }
+
+        void butterfly4(Complex *out, int fstride, int m) const {
+            // multiplication by -i (forward) or +i (inverse)
+            const float rot = inverse ? 1.0f : -1.0f;
+            for(int u = 0; u < m; ++u){
+                Complex a0 = out[u];
+                Complex a1 = out[u + m] * twiddles[u * fstride];
+                Complex a2 = out[u + 2 * m] * twiddles[2 * u * fstride];
+                Complex a3 = out[u + 3 * m] * twiddles[3 * u * fstride];
+                Complex s0 = a0 + a2, s1 = a0 - a2;
+                Complex s2 = a1 + a3, s3 = a1 - a3;
+                s3 = Complex(-rot * s3.imag(), rot * s3.real());
+                out[u]         = s0 + s2;
+                out[u + m]     = s1 + s3;
+                out[u + 2 * m] = s0 - s2;
+                out[u + 3 * m] = s1 - s3;
+            }
+        }
+
+        void butterfly(Complex *out, int fstride, int m, int p) const {
+            Complex stack[32];
+            std::vector<Complex> heap;
+            Complex *scratch = stack;
+            if(p > 32){
+                heap.resize(p);
+                scratch = &heap[0];
+            }
+            for(int u = 0; u < m; ++u){
+                for(int q = 0, k = u; q < p; ++q, k += m){
+                    scratch[q] = out[k];
+                }
+                for(int q1 = 0, k = u; q1 < p; ++q1, k += m){
+                    int tw = 0;
+                    Complex sum = scratch[0];
+                    for(int q = 1; q < p; ++q){
+                        tw += fstride * k;
+                        if(tw >= n) tw -= n;
+                        sum += scratch[q] * twiddles[tw];
+                    }
+                    out[k] = sum;
+                }
+            }
+        }
+
+        int n;
+        bool inverse;
+        std::vector<int> factors;
+        std::vector<Complex> twiddles;
+    };
+
+    /**
+     * 2D FFT over a row-major complex buffer (rows x cols)
+     *
+     * The inverse transform is normalized (as ifft2 in Matlab).
+     */
+    class FFT2D {
+    public:
+
+        FFT2D() : rows(0), cols(0) {}
+        FFT2D(int h, int w, bool inverse = false)
+        : rows(h), cols(w), rowPlan(w, inverse), colPlan(h, inverse), scale(inverse ? 1.0f / (h * w) : 1.0f) {
+        }
+
+        /**
+         * In-place transform of a rows x cols buffer
+         */
+        void transform(Complex *data) const {
+            std::vector<Complex> tmp(std::max(rows, cols));
+            // transform rows
+            for(int y = 0; y < rows; ++y){
+                Complex *row = data + y * cols;
+                rowPlan.transform(row, &tmp[0]);
+                std::copy(tmp.begin(), tmp.begin() + cols, row);
+            }
+            // transform columns
+            for(int x = 0; x < cols; ++x){
+                colPlan.transform(data + x, &tmp[0], cols);
+                for(int y = 0; y < rows; ++y){
+                    data[y * cols + x] = tmp[y] * scale;
+                }
+            }
+        }
+
+        inline void operator()(Complex *data) const {
+            transform(data);
+        }
+
+        int rows;
+        int cols;
+
+    private:
+        FFTPlan rowPlan;
+        FFTPlan colPlan;
+        float scale;
+    };
+
+}
+
+#endif	/* MATH_FFT_H */
+
@@ -19,18 +19,22 @@ namespace pm {
     
     struct ImageSet {
 
-		ImageSet() {}
+		ImageSet() : N(0) {}
 		explicit ImageSet(size_t n) : N(n) {
 			if(N > 0) {
 				stack.reset(new Mat[N]());
 			}
 		}
 
-		//! Element access
+		//! Element access (by value, the images may be column-major views)
 		template <typename T>
-        inline const T & at(int y, int x, int index) const {
+        inline T at(int y, int x, int index) const {
             assert(index >= 0 && index < N && "Image index out of bounds");
-            return stack[index].at<T>(y, x);
+            const Mat &img = stack[index];
+            if(img.layout() == IM_ROW_MAJOR){
+                return img.at<T>(y, x); // direct load, no channel gather
+            }
+            return img.pixel<T>(y, x);
 		}
 		template <typename T>
         inline T & at(int y, int x, int index) {
@@ -44,7 +48,7 @@ namespace pm {
             return at<T>(i.y, i.x, i.index);
         }
         template <typename T, typename S>
-        inline const typename std::enable_if<std::is_integral<S>::value, T>::type &at(const IndexedPoint<S> &i) const {
+        inline typename std::enable_if<std::is_integral<S>::value, T>::type at(const IndexedPoint<S> &i) const {
             return at<T>(i.y, i.x, i.index);
         }
         
@@ -74,6 +78,15 @@ namespace pm {
             return N;
         }
         
+        //! memory of the images
+        inline size_t memory() const {
+            size_t bytes = 0;
+            for(size_t i = 0; i < N; ++i){
+                bytes += stack[i].memory();
+            }
+            return bytes;
+        }
+        
     private:
 		boost::shared_array<Mat> stack;
         size_t N;
@@ -8,12 +8,23 @@
 #ifndef IM_MASK_H
 #define	IM_MASK_H
 
+#include "bounds.h"
 #include "mat.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace pm {
     
     typedef Mat Mask;
     
+    /**
+     * \brief Scanline filter from a mask
+     *
+     * By default, the non-zero indices are skipped.
+     * With Result = true, only the non-zero indices are processed.
+     * An empty mask filters nothing.
+     */
     template< typename T, bool Result = false >
     struct MaskFilter {
         
@@ -22,7 +33,7 @@ namespace pm {
          */
         unsigned int operator()(const T &p, bool) const {
             if(!mask.empty()){
-                return mask.at<float>(p.y, p.x) != 0.0f;
+                return (mask.at<float>(p.y, p.x) != 0.0f) != Result;
             }
             return 0.0f;
         }
@@ -33,6 +44,98 @@ namespace pm {
         const Mask mask;
     };
     
+    //! whether a mask element is non-zero (first channel, any depth and layout)
+    inline bool maskValue(const Mask &m, int y, int x) {
+        switch(m.depth()){
+            case IM_8U:
+            case IM_8S:  return m.pixel<unsigned char>(y, x) != 0;
+            case IM_32S: return m.pixel<int>(y, x) != 0;
+            case IM_32F: return m.pixel<float>(y, x) != 0.0f;
+            case IM_64F: return m.pixel<double>(y, x) != 0.0;
+            default:
+                assert(0 && "Unsupported mask type");
+                return false;
+        }
+    }
+    
+    /**
+     * \brief Mask of the pixels within a list of rectangles
+     *
+     * \param rects
+     *          rectangles with inclusive bounds (x in [0], y in [1]),
+     *          clamped to the mask
+     */
+    inline Mask rectMask(int rows, int cols, const std::vector<Bounds2i> &rects) {
+        Mask m = Mat::zeros(rows, cols, IM_32FC1);
+        for(const Bounds2i &r : rects){
+            for(int y = std::max(0, r.min[1]), y1 = std::min(rows - 1, r.max[1]); y <= y1; ++y){
+                for(int x = std::max(0, r.min[0]), x1 = std::min(cols - 1, r.max[0]); x <= x1; ++x){
+                    m.at<float>(y, x) = 1.0f;
+                }
+            }
+        }
+        return m;
+    }
+    
+    /**
+     * \brief Mask of the patches overlapping dirty pixels
+     *
+     * The patch at (y, x) covers the pixels [y;y+patchSize) x [x;x+patchSize).
+     * It is selected if any dirty pixel is within that window grown by halo,
+     * so that the halo lets the propagation carry the changes around the
+     * dirty region.
+     *
+     * \param dirty
+     *          pixel mask (image size)
+     * \param rows
+     *          number of patch rows (height of the field)
+     * \param cols
+     *          number of patch columns (width of the field)
+     * \return a float mask of size rows x cols (1 for selected patches)
+     */
+    inline Mask patchRegion(const Mask &dirty, int rows, int cols, int patchSize, int halo = 0) {
+        Mask region = Mat::zeros(rows, cols, IM_32FC1);
+        if(dirty.empty()){
+            return region;
+        }
+        // integral image of the dirty pixels
+        const int h = dirty.height, w = dirty.width;
+        std::vector<int> sum((h + 1) * (w + 1), 0);
+        for(int y = 0; y < h; ++y){
+            int row = 0;
+            for(int x = 0; x < w; ++x){
+                row += maskValue(dirty, y, x) ? 1 : 0;
+                sum[(y + 1) * (w + 1) + x + 1] = sum[y * (w + 1) + x + 1] + row;
+            }
+        }
+        // window count per patch
+        for(int y = 0; y < rows; ++y){
+            const int y0 = std::max(0, y - halo), y1 = std::min(h, y + patchSize + halo);
+            if(y0 >= y1) continue;
+            for(int x = 0; x < cols; ++x){
+                const int x0 = std::max(0, x - halo), x1 = std::min(w, x + patchSize + halo);
+                if(x0 >= x1) continue;
+                int n = sum[y1 * (w + 1) + x1] - sum[y0 * (w + 1) + x1]
+                      - sum[y1 * (w + 1) + x0] + sum[y0 * (w + 1) + x0];
+                if(n > 0){
+                    region.at<float>(y, x) = 1.0f;
+                }
+            }
+        }
+        return region;
+    }
+    
+    //! number of non-zero elements
+    inline size_t maskCount(const Mask &m) {
+        size_t n = 0;
+        for(int y = 0; y < m.height; ++y){
+            for(int x = 0; x < m.width; ++x){
+                n += maskValue(m, y, x) ? 1 : 0;
+            }
+        }
+        return n;
+    }
+    
 }
 
 #endif	/* IM_MASK_H */
@@ -10,21 +10,42 @@
 
 #include "defs.h"
 #include "iterator2d.h"
+#include "memory.h"
 #include "point.h"
 
-#include <boost/shared_array.hpp>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+#include <stdint.h>
 
 namespace pm {
 	
-	/**
-	 * Matrix data pointer
-	 */
-	typedef boost::shared_array<byte> DataPtr;
-	
 #ifndef SAFE_MAT
 #define SAFE_MAT 0
 #endif
 
+	/**
+	 * Memory layout of the matrix elements
+	 */
+	enum MatLayout {
+		IM_ROW_MAJOR	= 0,	// rows of interleaved channels (default)
+		IM_COL_MAJOR	= 1		// column-major channel planes (as Matlab arrays)
+	};
+
+	/**
+	 * Word of the channels of a pixel type (its scalar for vectors)
+	 */
+	template <typename T, typename Scalar = void>
+	struct PixelWord {
+		typedef T type;
+	};
+	template <typename T>
+	struct PixelWord<T, typename std::conditional<true, void, typename T::scalar>::type> {
+		typedef typename T::scalar type;
+	};
+
 	/**
 	 * Image matrix representation
 	 */
@@ -51,35 +72,80 @@ namespace pm {
 			return IM_MAT_CN(flags);
 		}
 		
-		Mat() : flags(IM_UNKNOWN){
+		Mat() : flags(IM_UNKNOWN), order(IM_ROW_MAJOR){
+            stride[0] = stride[1] = stride[2] = 0;
 		}
         
-        Mat(const Mat &m) : height(m.height), width(m.width), flags(m.flags), data(m.data) {
+        Mat(const Mat &m) : height(m.height), width(m.width), flags(m.flags), order(m.order), data(m.data) {
             step[0] = m.step[0];
             step[1] = m.step[1];
+            step[2] = m.step[2];
+            stride[0] = m.stride[0];
+            stride[1] = m.stride[1];
+            stride[2] = m.stride[2];
         }
 		
-		Mat(int h, int w, int dataType) : height(h), width(w), flags(dataType){
+		Mat(int h, int w, int dataType) : height(h), width(w), flags(dataType), order(IM_ROW_MAJOR){
 			create(IM_SIZEOF(dataType));
 		}
         
-        Mat(int h, int w, size_t elemSize, int channels) : height(h), width(w), flags(IM_MAKETYPE(IM_USRTYPE, channels)){
+        Mat(int h, int w, size_t elemSize, int channels) : height(h), width(w), flags(IM_MAKETYPE(IM_USRTYPE, channels)), order(IM_ROW_MAJOR){
 			create(elemSize);
 		}
-        
+
+        //! Wrap existing contiguous row-major data (no copy, the pointer owns it)
+        Mat(int h, int w, int dataType, size_t elemSize, const DataPtr &ptr) : height(h), width(w), flags(dataType), order(IM_ROW_MAJOR), data(ptr){
+            step[0] = elemSize;
+            step[1] = w * elemSize;
+            step[2] = 0;
+            setRowMajorStrides();
+        }
+
+        /**
+         * \brief Wrap column-major channel planes (e.g. Matlab array data) without copy
+         *
+         * Such matrices can only be read by value with pixel(), not through
+         * pointers or references (ptr / at), since channels are not contiguous.
+         */
+        static Mat columnMajor(int h, int w, int dataType, const DataPtr &ptr) {
+            Mat m;
+            m.height = h;
+            m.width = w;
+            m.flags = dataType;
+            m.order = IM_COL_MAJOR;
+            m.data = ptr;
+            assert(IM_MAT_DEPTH(dataType) != IM_USRTYPE && "Column-major data requires a standard depth");
+            const int depthSize = IM_SIZEOF_DEPTH(IM_MAT_DEPTH(dataType));
+            m.step[0] = IM_SIZEOF(dataType);
+            m.step[1] = h * depthSize;      // next column
+            m.step[2] = h * w * depthSize;  // next channel plane
+            m.stride[0] = depthSize;
+            m.stride[1] = m.step[1];
+            m.stride[2] = m.step[2];
+            return m;
+        }
+
     protected:
         
-        void create(size_t elemSize){
+        void create(size_t elemSize, bool zero = false){
             size_t byteCount = elemSize * height * width;
 			if(byteCount > 0){
-				byte *content = new byte[byteCount];
-				data.reset(content);
+				data = allocate(byteCount, zero); // aligned, see memory.h
 				step[0] = elemSize;
 				step[1] = width * elemSize;
+				step[2] = 0;
 			} else {
 				std::cerr << "Matrix with datasize=" << elemSize << ", datatype=" << flags << "\n";
-				step[0] = step[1] = 0;
+				step[0] = step[1] = step[2] = 0;
 			}
+            setRowMajorStrides();
+        }
+
+        //! pixel strides of interleaved channels
+        void setRowMajorStrides() {
+            stride[0] = step[1];
+            stride[1] = step[0];
+            stride[2] = channels() > 0 ? step[0] / channels() : step[0];
         }
         
     public:
@@ -91,6 +157,46 @@ namespace pm {
 		inline bool empty() const {
 			return !data;
 		}
+
+		//! memory reserved for the data (shared buffers are counted by each owner)
+		inline size_t memory() const {
+			return empty() ? 0 : allocatedBytes(size_t(height) * width * elemSize());
+		}
+
+		inline MatLayout layout() const {
+			return order;
+		}
+
+		//! whether the elements are contiguous row-major rows (as allocated)
+		inline bool isContiguous() const {
+			return order == IM_ROW_MAJOR && step[1] == width * step[0];
+		}
+
+		/**
+		 * \brief Contiguous row-major version of the matrix
+		 *
+		 * \return the matrix itself if it already is, else a copy
+		 *         gathered with the strides of its layout
+		 */
+		Mat contiguous() const {
+			if(empty() || isContiguous()){
+				return *this;
+			}
+			Mat m(height, width, size_t(elemSize()), channels());
+			m.flags = flags;
+			m.setRowMajorStrides();
+			const int C = channels(), word = elemSize() / C;
+			for(int y = 0; y < height; ++y){
+				for(int x = 0; x < width; ++x){
+					const byte *src = data.get() + y * stride[0] + x * stride[1];
+					byte *dst = m.data.get() + y * m.step[1] + x * m.step[0];
+					for(int c = 0; c < C; ++c){
+						std::memcpy(dst + c * word, src + c * stride[2], word);
+					}
+				}
+			}
+			return m;
+		}
         
         virtual int size0() const {
             return width;
@@ -100,11 +206,11 @@ namespace pm {
         }
 		
 		inline static Mat zeros(int rows, int cols, int type) {
-			Mat m(rows, cols, type);
-			int elemSize = IM_SIZEOF(type);
-			int byteCount = elemSize * rows * cols;
-			byte *ptr = m.ptr();
-			std::fill(ptr, ptr + byteCount, 0);
+			Mat m;
+			m.height = rows;
+			m.width = cols;
+			m.flags = type;
+			m.create(IM_SIZEOF(type), true); // lazily zeroed when large
 			return m;
 		}
 		
@@ -116,6 +222,7 @@ namespace pm {
 		//! Pointer access
 		template <typename T>
 		inline const T *ptr(int y, int x) const {
+            assert(order == IM_ROW_MAJOR && "Pointer access to column-major data, use pixel()!");
             assert(x >= 0 && y >= 0 && x < width && y < height && "Pixel pointer out of bounds!");
             assert((sizeof(T) % elemSize() == 0 || elemSize() % sizeof(T) == 0) && "Pointer to data overlapping multiple elements, but misaligned!");
 			const byte *ref = data.get();
@@ -123,6 +230,7 @@ namespace pm {
 		}
 		template <typename T>
 		inline T *ptr(int y, int x) {
+            assert(order == IM_ROW_MAJOR && "Pointer access to column-major data, use pixel()!");
             assert(x >= 0 && y >= 0 && x < width && y < height && "Pixel pointer out of bounds!");
             assert((sizeof(T) % elemSize() == 0 || elemSize() % sizeof(T) == 0) && "Pointer to data overlapping multiple elements, but misaligned!");
 			byte *ref = data.get();
@@ -141,6 +249,31 @@ namespace pm {
 			return *ptr<T>(y, x);
 		}
         
+        /**
+         * \brief Element by value, for any layout
+         *
+         * The channels are gathered with the strides of the layout, so that
+         * both layouts share the same code path.
+         */
+        template <typename T>
+        inline T pixel(int y, int x) const {
+            typedef typename PixelWord<T>::type Word;
+            assert(x >= 0 && y >= 0 && x < width && y < height && "Pixel out of bounds!");
+            assert(sizeof(T) <= size_t(elemSize()) && "Pixel type larger than the elements!");
+            assert((order == IM_ROW_MAJOR || sizeof(Word) == size_t(stride[0])) && "Pixel word does not match the column-major depth!");
+            T value;
+            Word *dst = reinterpret_cast<Word *>(&value);
+            const byte *src = data.get() + y * stride[0] + x * stride[1];
+            for(size_t c = 0; c < sizeof(T) / sizeof(Word); ++c){
+                dst[c] = *reinterpret_cast<const Word *>(src + c * stride[2]);
+            }
+            return value;
+        }
+        template <typename T>
+        inline T pixel(const Point2i &p) const {
+            return pixel<T>(p.y, p.x);
+        }
+
         template <typename T>
         inline const T &at(const Point2i &p) const {
             return at<T>(p.y, p.x);
@@ -156,8 +289,10 @@ namespace pm {
 		
 	protected:
 		int flags;
+		MatLayout order;
 		DataPtr data;
-		int step[2];
+		int step[3];
+		int stride[3];  //!< byte strides of the rows, columns and channels (pixel)
 	};
 	
 	/**
@@ -0,0 +1,116 @@
+/*
+ * File:   memory.h
+ */
+
+#ifndef MATH_MEMORY_H
+#define	MATH_MEMORY_H
+
+#include "defs.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <boost/shared_array.hpp>
+
+namespace pm {
+
+	/**
+	 * Matrix data pointer
+	 */
+	typedef boost::shared_array<byte> DataPtr;
+
+// alignment of the matrix data (cache line, enough for any SIMD load)
+#ifndef MAT_ALIGNMENT
+#define MAT_ALIGNMENT 64
+#endif
+
+// buffers from this size are mapped directly (lazily zeroed by the kernel)
+#ifndef MAT_MAP_THRESHOLD
+#define MAT_MAP_THRESHOLD (4 << 20)
+#endif
+
+// whether mapped buffers should use transparent huge pages
+#ifndef MAT_HUGE_PAGES
+#define MAT_HUGE_PAGES 1
+#endif
+
+	/**
+	 * \brief Release of the buffers from allocate()
+	 */
+	struct MatDeleter {
+		size_t mapped; //!< size of the mapping, 0 for heap buffers
+
+		explicit MatDeleter(size_t m = 0) : mapped(m) {}
+
+		inline void operator()(byte *ptr) const {
+			if(mapped){
+				munmap(ptr, mapped);
+			} else {
+				std::free(ptr);
+			}
+		}
+	};
+
+	/**
+	 * \brief Allocate matrix data aligned on MAT_ALIGNMENT bytes
+	 *
+	 * Large buffers are anonymous mappings (page aligned, optionally backed
+	 * by huge pages), which the kernel zeroes only when first touched,
+	 * so that zeroed buffers cost nothing until used.
+	 * Smaller buffers come from the heap and are cleared explicitly.
+	 *
+	 * \param bytes
+	 *          the size of the buffer
+	 * \param zero
+	 *          whether the content must be zeroed
+	 * \return the data pointer (throws std::bad_alloc on failure)
+	 */
+	inline DataPtr allocate(size_t bytes, bool zero = false) {
+		if(bytes >= MAT_MAP_THRESHOLD){
+			void *ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(ptr != MAP_FAILED){
+#if MAT_HUGE_PAGES && defined(MADV_HUGEPAGE)
+				madvise(ptr, bytes, MADV_HUGEPAGE); // only a hint
+#endif
+				return DataPtr(static_cast<byte *>(ptr), MatDeleter(bytes));
+			}
+			// else fall back to the heap
+		}
+		void *ptr = NULL;
+		if(posix_memalign(&ptr, MAT_ALIGNMENT, bytes) != 0){
+			throw std::bad_alloc();
+		}
+		if(zero){
+			std::memset(ptr, 0, bytes);
+		}
+		return DataPtr(static_cast<byte *>(ptr), MatDeleter());
+	}
+
+	/**
+	 * \brief Memory actually reserved by allocate() for a buffer
+	 *
+	 * Mapped buffers take whole pages, heap buffers are rounded
+	 * to the alignment (allocator headers are not counted).
+	 */
+	inline size_t allocatedBytes(size_t bytes) {
+		if(bytes >= MAT_MAP_THRESHOLD){
+			const size_t page = sysconf(_SC_PAGESIZE);
+			return (bytes + page - 1) / page * page;
+		}
+		return (bytes + MAT_ALIGNMENT - 1) / MAT_ALIGNMENT * MAT_ALIGNMENT;
+	}
+
+	//! whether a pointer is aligned for a given type (or boundary)
+	template <typename T>
+	inline bool isAligned(const void *ptr, size_t alignment = alignof(T)) {
+		return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+	}
+
+}
+
+#endif	/* MATH_MEMORY_H */
@@ -0,0 +1,124 @@
+/*
+ * File:   database.h
+ */
+
+#ifndef DATABASE_H
+#define	DATABASE_H
+
+#include "defs.h"
+#include "images.h"
+#include "strings.h"
+
+#include <stdint.h>
+
+namespace pm {
+
+    /**
+     * Sets of an exemplar database
+     */
+    enum ExemplarSet {
+        DB_LEFT = 0,
+        DB_RIGHT,
+        DB_UV,
+        DB_DESCRIPTOR,
+        DB_NUM_SETS
+    };
+
+    inline const char *exemplarSetName(int s) {
+        static const char *names[DB_NUM_SETS] = { "left", "right", "uv", "descriptor" };
+        return names[s];
+    }
+
+    /**
+     * \brief Exemplar images kept in memory across mex calls
+     *
+     * It is created and released by ixdb (which stays locked while some
+     * database is alive) and passed to the other mex functions as an opaque
+     * uint64 id in place of the cell of images.
+     * Ids are never reused, and only ixdb knows which ones are alive, so that
+     * the other mex functions resolve them through ixdb('get', id).
+     */
+    struct ExemplarDB {
+        ImageSet sets[DB_NUM_SETS];
+    };
+
+    //! whether an array is a database handle (uint64 scalar)
+    inline bool mxIsHandle(const mxArray *arr) {
+        return arr && mxIsUint64(arr) && mxGetNumberOfElements(arr) == 1;
+    }
+
+    inline mxArray *mxCreateHandle(uint64_t value) {
+        mwSize sz[2] = {1, 1};
+        mxArray *arr = mxCreateNumericArray(2, sz, mxUINT64_CLASS, mxREAL);
+        *reinterpret_cast<uint64_t *>(mxGetData(arr)) = value;
+        return arr;
+    }
+
+    //! value of a handle
+    inline uint64_t mxHandleValue(const mxArray *arr) {
+        if(!mxIsHandle(arr)){
+            mexErrMsgIdAndTxt("MATLAB:mex:invalidHandle", "Database handle should be a uint64 scalar.");
+        }
+        return *reinterpret_cast<const uint64_t *>(mxGetData(arr));
+    }
+
+    /**
+     * \brief Live database of a handle
+     *
+     * The id is validated by ixdb, which returns the address of the database
+     * (or fails for unknown or released ids).
+     * The database cannot be released during the current mex call.
+     */
+    inline ExemplarDB *mxHandleToDatabase(const mxArray *arr) {
+        mxHandleValue(arr); // check the type
+        mxArray *rhs[2] = { mxCreateString("get"), mxDuplicateArray(arr) };
+        mxArray *lhs[1] = { NULL };
+        int err = mexCallMATLAB(1, lhs, 2, rhs, "ixdb");
+        mxDestroyArray(rhs[0]);
+        mxDestroyArray(rhs[1]);
+        if(err || !mxIsHandle(lhs[0])){
+            mexErrMsgIdAndTxt("MATLAB:mex:invalidHandle", "Invalid or released database handle.");
+        }
+        ExemplarDB *db = reinterpret_cast<ExemplarDB *>(uintptr_t(mxHandleValue(lhs[0])));
+        mxDestroyArray(lhs[0]);
+        return db;
+    }
+
+    inline ExemplarSet mxExemplarSet(const mxArray *arr, ExemplarSet defaultSet) {
+        if(!arr){
+            return defaultSet;
+        }
+        for(int s = 0; s < DB_NUM_SETS; ++s){
+            if(mxStringEquals(arr, exemplarSetName(s))){
+                return ExemplarSet(s);
+            }
+        }
+        mexErrMsgIdAndTxt("MATLAB:mex:invalidSet", "Unknown database set (left, right, uv or descriptor).");
+        return defaultSet;
+    }
+
+    /**
+     * \brief Image set from either a cell of images or a database handle
+     *
+     * \param arr
+     *          the cell array or the uint64 handle
+     * \param set
+     *          the set of the database to use with a handle
+     * \param view
+     *          whether the single images of a cell can be views of the
+     *          Matlab data (@see mxArrayToImageSet)
+     */
+    inline ImageSet mxExemplarImages(const mxArray *arr, ExemplarSet set, bool view = false) {
+        if(!mxIsHandle(arr)){
+            return mxArrayToImageSet(arr, "Invalid image set", view);
+        }
+        const ImageSet &images = mxHandleToDatabase(arr)->sets[set];
+        if(images.size() == 0){
+            mexErrMsgIdAndTxt("MATLAB:mex:invalidSet", "The database has no %s images.", exemplarSetName(set));
+        }
+        return images;
+    }
+
+}
+
+#endif	/* DATABASE_H */
@@ -11,8 +11,14 @@
 #include "defs.h"
 #include "../math/mat.h"
 #include "../math/imageset.h"
+#include "../io/cache.h"
 
 namespace pm {
+
+    //! deleter for data owned by Matlab
+    struct NoDelete {
+        void operator()(byte *) const {}
+    };
     
     inline mxArray *mxCreateMatrix(int rows, int cols, mxClassID type = mxSINGLE_CLASS) {
         mwSize sz[2] = {rows, cols};
@@ -77,6 +83,12 @@ namespace pm {
         }
     }
 
+    //! whether a value is infinite or too large to be a pixel (d + 1 == d)
+    template <typename Scalar>
+    inline bool mxInvalidPixel(Scalar d) {
+        return (d + 1) == d;
+    }
+
     template <typename Scalar>
     inline void mxCheckImage(const Image &img, const char *errMsg = "Corrupted image with pixels out of bounds!") {
         bool err = false;
@@ -85,7 +97,7 @@ namespace pm {
                 const Scalar *ptr = img.ptr<Scalar>(y, x);
                 for (int c = 0; c < img.channels(); ++c) {
                     Scalar d = ptr[c];
-                    if ((d + 1) == d) {
+                    if (mxInvalidPixel(d)) {
                         std::cout << "Invalid p@" << y << "/" << x << "/c" << c << " = " << d << "\n";
                         err = true;
                     }
@@ -95,6 +107,37 @@ namespace pm {
         if (err) mexErrMsgIdAndTxt("MATLAB:mex:invalid_image", errMsg);
     }
 
+    /**
+     * \brief Check the raw data of an image array in a single contiguous pass
+     *
+     * The invalid pixels are only located upon error.
+     */
+    template <typename Scalar>
+    inline void mxCheckArray(const mxArray *arr, const char *errMsg) {
+        const Scalar *data = reinterpret_cast<const Scalar *> (mxGetData(arr));
+        const size_t n = mxGetNumberOfElements(arr);
+        bool err = false;
+        for (size_t i = 0; i < n; ++i) {
+            err |= mxInvalidPixel(data[i]);
+        }
+        if (err) {
+            int h = mxGetDimensions(arr)[0];
+            int w = mxGetDimensions(arr)[1];
+            int num_ch = mxGetNumberOfDimensions(arr) < 3 ? 1 : mxGetDimensions(arr)[2];
+            for (int c = 0; c < num_ch; ++c) {
+                for (int x = 0; x < w; ++x) {
+                    for (int y = 0; y < h; ++y) {
+                        Scalar d = data[y + x * h + c * h * w];
+                        if (mxInvalidPixel(d)) {
+                            std::cout << "Invalid p@" << y << "/" << x << "/c" << c << " = " << d << "\n";
+                        }
+                    }
+                }
+            }
+            mexErrMsgIdAndTxt("MATLAB:mex:invalid_image", errMsg);
+        }
+    }
+
     template <typename Scalar>
     inline Image mxArrayToImage(const mxArray *arr, const char *errMsg) {
         if (!mxIsNumeric(arr)) {
@@ -110,13 +153,16 @@ namespace pm {
         Image img(h, w, IM_MAKETYPE(DataDepth<Scalar>::value, num_ch));
         const Scalar *data = reinterpret_cast<const Scalar *> (mxGetData(arr));
         
-        // /!\ img.step[2] might be wrong! do not use at(y, x, ch) indexing!
-        // => use img.ptr(y, x)
+        // the values are checked while copying, the details are only
+        // gathered by mxCheckImage upon error
+        bool err = false;
         if (num_ch == 1) {
             for (int y = 0; y < img.rows; ++y) {
                 for (int x = 0; x < img.cols; ++x) {
                     // transposing!
-                    img.at<Scalar>(y, x) = data[y + x * img.rows];
+                    Scalar v = data[y + x * img.rows];
+                    err |= mxInvalidPixel(v);
+                    img.at<Scalar>(y, x) = v;
                 }
             }
         } else {
@@ -124,19 +170,39 @@ namespace pm {
                 for (int x = 0; x < img.cols; ++x) {
                     Scalar *iptr = img.ptr<Scalar>(y, x);
                     for (int ch = 0; ch < img.channels(); ++ch) {
-                        // std::cout << "at(" << y << ", " << x << ", " << ch << ") = ";
                         // transposing!
                         Scalar v = data[y + x * img.rows + offset * ch];
-                        // std::cout << v << "\n";
+                        err |= mxInvalidPixel(v);
                         iptr[ch] = v;
                     }
                 }
             }
         }
-        mxCheckImage<Scalar>(img, errMsg);
+        if (err) mxCheckImage<Scalar>(img, errMsg);
         return img;
     }
 
+    /**
+     * \brief Column-major view of an image array (no copy, no transposition)
+     *
+     * The view is only valid as long as the array, i.e. during the mex call,
+     * and its pixels can only be read by value (Mat::pixel, ImageSet::at).
+     */
+    template <typename Scalar>
+    inline Image mxArrayToImageView(const mxArray *arr, const char *errMsg) {
+        if (!mxIsNumeric(arr)) {
+            mexErrMsgIdAndTxt("MATLAB:mex:invalidInput", "Invalid image array.");
+        }
+        assert(mxGetClassID(arr) == classID<Scalar>());
+        mxCheckArray<Scalar>(arr, errMsg);
+        int h = mxGetDimensions(arr)[0];
+        int w = mxGetDimensions(arr)[1];
+        int num_ch = mxGetNumberOfDimensions(arr) < 3 ? 1 : mxGetDimensions(arr)[2];
+        // the array keeps ownership of its data
+        DataPtr data(reinterpret_cast<byte *>(mxGetData(arr)), NoDelete());
+        return Mat::columnMajor(h, w, IM_MAKETYPE(DataDepth<Scalar>::value, num_ch), data);
+    }
+
     inline Image mxArrayToImage(const mxArray *arr, const char *err = "Corrupted image with pixels out of bounds!") {
         switch (mxGetClassID(arr)) {
             case mxINT8_CLASS: return mxArrayToImage<char>(arr, err);
@@ -149,7 +215,34 @@ namespace pm {
         }
     }
     
-    inline ImageSet mxArrayToImageSet(const mxArray *arr, const char *err = "Invalid image set") {
+    /**
+     * Map an image from a cache file reference 'file.pmc:level' (@see io/cache.h)
+     */
+    inline Image mxCachedImage(const mxArray *arr, const char *plane = "image") {
+        char buf[1024];
+        if(mxGetString(arr, buf, sizeof(buf))){
+            mexErrMsgIdAndTxt("MATLAB:mex:mxCachedImage", "Invalid cache reference.");
+        }
+        std::string file;
+        int level;
+        parseCacheSpec(buf, &file, &level);
+        CacheFile cache(file);
+        Image img = cache.get(plane, level);
+        if(img.empty()){
+            mexErrMsgIdAndTxt("MATLAB:mex:mxCachedImage", "Missing plane %s at level %d of %s", plane, level, file.c_str());
+        }
+        return img;
+    }
+
+    /**
+     * \brief Image set from a cell of images or cache references
+     *
+     * \param view
+     *          whether single images can be views of the Matlab data,
+     *          which is only valid during the mex call and can only be
+     *          read by value (const ImageSet::at), not through Mat::ptr / at
+     */
+    inline ImageSet mxArrayToImageSet(const mxArray *arr, const char *err = "Invalid image set", bool view = false) {
         if(!mxIsCell(arr)){
             mexErrMsgIdAndTxt("MATLAB:mex:mxArrayToImageSet", "Image set should be of cell type.");
         }
@@ -157,7 +250,12 @@ namespace pm {
         ImageSet set(N);
         for(unsigned int i = 0; i < N; ++i){
             const mxArray *cell = mxGetCell(arr, i);
-            if(cell){
+            if(cell && mxIsChar(cell)){
+                set[i] = mxCachedImage(cell);
+            } else if(cell && view && mxGetClassID(cell) == mxSINGLE_CLASS){
+                // the targets are only read by value => no copy
+                set[i] = mxArrayToImageView<float>(cell, "Invalid cell image for image set");
+            } else if(cell){
                 set[i] = mxArrayToImage(cell, "Invalid cell image for image set");
             } else {
                 mexErrMsgIdAndTxt("MATLAB:mex:mxArrayToImageSet", "Cell image was empty for image set!");
@@ -10,6 +10,7 @@
 
 #include "defs.h"
 #include "images.h"
+#include "../math/bounds.h"
 
 #include <string>
 #include <vector>
@@ -139,6 +140,11 @@ namespace pm {
             return mxHasField(options, 0, name);
         }
         
+        //! raw field (NULL if missing)
+        const mxArray *field(FieldName name) const {
+            return mxGetField(options, 0, name);
+        }
+        
         template <typename S = double>
         S scalar(FieldName name, S defaultValue) const {
             if(const mxArray *field = mxGetField(options, 0, name)){
@@ -177,6 +183,38 @@ namespace pm {
             return v;
         }
         
+        std::string string(FieldName name, const std::string &defaultValue) const {
+            if(const mxArray *field = mxGetField(options, 0, name)){
+                char buf[1024];
+                if(!mxIsChar(field) || mxGetString(field, buf, sizeof(buf))){
+                    mexErrMsgIdAndTxt("MATLAB:mex:options", "Option %s should be a string.", name);
+                }
+                return std::string(buf);
+            }
+            return defaultValue;
+        }
+        
+        /**
+         * \brief Rectangles from a N x 4 matrix of [x y w h] rows
+         *
+         * MATLAB coordinates (1-based) are converted into inclusive 0-based bounds.
+         */
+        std::vector<Bounds2i> rects(FieldName name) const {
+            std::vector<Bounds2i> r;
+            if(const mxArray *field = mxGetField(options, 0, name)){
+                std::vector<int> v = vector<int>(name);
+                int n = mxGetM(field);
+                if(v.size() != 4 * n){
+                    mexErrMsgIdAndTxt("MATLAB:mex:options", "Option %s should be a N x 4 matrix.", name);
+                }
+                for(int i = 0; i < n; ++i){
+                    Vec2i from(v[i] - 1, v[n + i] - 1);
+                    r.push_back(Bounds2i(from, from + Vec2i(v[2 * n + i] - 1, v[3 * n + i] - 1)));
+                }
+            }
+            return r;
+        }
+        
         Image image(FieldName name) const {
             Image img;
             if(const mxArray *field = mxGetField(options, 0, name)){
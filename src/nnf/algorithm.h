@@ -8,6 +8,8 @@
 #ifndef ALGORITHM_H
 #define	ALGORITHM_H
 
+#include "stats.h"
+
 #include <functional>
 
 namespace pm {
@@ -42,6 +44,9 @@ namespace pm {
     
     /**
      * Algorithm sequence wrapper with result verbosity
+     *
+     * With PM_STEP_STATS, each step also accumulates its wall time and
+     * the counters of its patch trials (see stats.h).
      */
     struct VerboseAlgorithm {
         typedef std::function<uint(const Point2i &, bool)> AlgorithmPart;
@@ -49,7 +54,19 @@ namespace pm {
             uint res = 0;
             for(uint j = 0, n = seq.size(); j < n; ++j){
                 AlgorithmPart &p = seq[j];
+#if PM_STEP_STATS
+                StepStats &trials = trialCounters();
+                const StepStats before = trials;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                uint c = p(i, rev);
+                stats[j][StepStats::Time] += std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+                for(int f = StepStats::DistEvals; f < StepStats::NumFields; ++f){
+                    stats[j][f] += trials[f] - before[f];
+                }
+#else
                 uint c = p(i, rev);
+#endif
                 res += c; // total count
                 results[j] += c; // per-algorithm count
             }
@@ -62,26 +79,37 @@ namespace pm {
             // result sequence
             results.resize(algo.seq.size());
             std::fill(results.begin(), results.end(), 0); // set to zero
+            stats.resize(algo.seq.size());
         }
         VerboseAlgorithm(){}
 
         VerboseAlgorithm &operator <<(AlgorithmPart p){
             seq.push_back(p);
             results.push_back(0);
+            stats.push_back(StepStats());
             return *this;
         }
         
         const std::vector<size_t> &counts() const {
             return results;
         }
+        //! accumulated statistics of each step (zero without PM_STEP_STATS)
+        const std::vector<StepStats> &statistics() const {
+            return stats;
+        }
         
     private:
         std::vector<AlgorithmPart> seq;
         std::vector<size_t> results;
+        std::vector<StepStats> stats;
     };
     
     /**
      * Diary recording convergence over iterations
+     *
+     * Each row is a step and each column an iteration. With PM_STEP_STATS,
+     * the rows of the successful updates are followed by blocks of rows
+     * (one per step) for each field of StepStats.
      */
     struct ConvergenceDiary {
         typedef std::vector<size_t> Sequence;
@@ -90,16 +118,24 @@ namespace pm {
         uint operator()(int iter, bool rev) {
             const std::vector<size_t> &sums = algorithm->counts();
             uint n = sums.size();
+            const uint rows = PM_STEP_STATS ? n * (1 + StepStats::NumFields) : n;
             if(data->empty()){
-                data->resize(n);
+                data->resize(rows);
+            }
+            if(totals.size() != rows){
+                totals.assign(rows, 0);
             }
             for(uint j = 0; j < n; ++j){
-                Sequence &seq = data->at(j);
-                size_t curr = sums[j];
-                size_t last = seq.empty() ? 0 : seq.back();
-                assert(last <= curr && "Convergence decrease?");
-                data->at(j).push_back(curr - last);
+                record(j, sums[j]);
             }
+#if PM_STEP_STATS
+            const std::vector<StepStats> &stats = algorithm->statistics();
+            for(int f = 0; f < StepStats::NumFields; ++f){
+                for(uint j = 0; j < n; ++j){
+                    record(n * (1 + f) + j, stats[j][f]);
+                }
+            }
+#endif
             return 0;
         }
         
@@ -108,8 +144,17 @@ namespace pm {
         }
         
     private:
+        //! store the increase of a cumulated value since the last iteration
+        inline void record(uint row, size_t curr) {
+            size_t &last = totals[row];
+            assert(last <= curr && "Convergence decrease?");
+            data->at(row).push_back(curr - last);
+            last = curr;
+        }
+
         const VerboseAlgorithm *algorithm;
         Data *data;
+        Sequence totals;
     };
     
 }
@@ -0,0 +1,150 @@
+/*
+ * File:   compact.h
+ */
+
+#ifndef NNF_COMPACT_H
+#define	NNF_COMPACT_H
+
+#include "patch.h"
+#include "../math/mat.h"
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <stdint.h>
+
+namespace pm {
+
+    /**
+     * \brief Compact k-NNF entry (8 bytes instead of 16)
+     *
+     * - dx, dy: offset of the patch relative to the query pixel
+     * - index: exemplar index (0xFFFF for no exemplar)
+     * - distance: log-quantized distance (see quantizeDistance)
+     */
+    struct CompactEntry {
+        int16_t dx;
+        int16_t dy;
+        uint16_t index;
+        uint16_t distance;
+    };
+
+    enum {
+        CompactNoIndex = 0xFFFF,
+        CompactNoDistance = 0xFFFF,         //!< infinite or unset distance
+        CompactDistanceScale = 1024,        //!< steps per power of two
+        CompactMinExponent = -24            //!< log2 of the smallest positive distance
+    };
+
+    /**
+     * \brief Quantize a distance as 1 + round((log2(d) + 24) * 1024)
+     *
+     * Positive distances in [2^-24, 2^40) keep a relative error below 3.4e-4
+     * (area-normalized distances of [0,1] images are typically 1e-3 to 1e-2),
+     * and the order is preserved, so that the heaps stay valid.
+     * Zero maps to 0, smaller positive distances to the floor (1), and the
+     * ones that do not fit, infinite and NaN ones to CompactNoDistance.
+     */
+    inline uint16_t quantizeDistance(float d) {
+        if(std::isnan(d)){
+            return CompactNoDistance;
+        } else if(d <= 0.0f){
+            return 0;
+        }
+        float q = (std::log2(d) - CompactMinExponent) * CompactDistanceScale + 0.5f;
+        if(q < 0.0f){
+            return 1;
+        }
+        return q + 1.0f < float(CompactNoDistance) ? uint16_t(q) + 1 : uint16_t(CompactNoDistance);
+    }
+
+    inline float expandDistance(uint16_t q) {
+        if(q == CompactNoDistance){
+            return std::numeric_limits<float>::infinity();
+        } else if(q == 0){
+            return 0.0f;
+        }
+        return std::exp2(float(q - 1) / CompactDistanceScale + CompactMinExponent);
+    }
+
+    //! exemplar index of a patch (single-exemplar patches have none)
+    inline int patchIndex(const Patch2ti &) {
+        return 0;
+    }
+    inline int patchIndex(const Patch2tix &p) {
+        return p.index;
+    }
+    inline void setPatchIndex(Patch2ti &, int) {
+    }
+    inline void setPatchIndex(Patch2tix &p, int index) {
+        p.index = index;
+    }
+
+    /**
+     * \brief Compact copy of the k-NNF entries
+     *
+     * \param data
+     *          the raw field entry (PatchData[K] per pixel)
+     * \param m
+     *          the output matrix with K CompactEntry per pixel
+     * \return false if an offset does not fit in 16 bits or an exemplar
+     *         index is above 65534 (m is then incomplete)
+     */
+    template <int K, typename PatchData>
+    bool compactEntries(const Mat &data, Mat &m) {
+        assert(data.elemSize() == sizeof(PatchData) * K && "Compacting an entry of invalid type");
+        m = Mat(data.height, data.width, sizeof(CompactEntry) * K, 4 * K);
+        const int h = data.height, w = data.width;
+        int overflows = 0;
+#pragma omp parallel for reduction(+:overflows)
+        for(int y = 0; y < h; ++y){
+            const PatchData *src = data.ptr<PatchData>(y, 0);
+            CompactEntry *dst = m.ptr<CompactEntry>(y, 0);
+            for(int x = 0; x < w; ++x){
+                for(int k = 0; k < K; ++k, ++src, ++dst){
+                    const int dx = src->patch.x - x, dy = src->patch.y - y;
+                    const int z = patchIndex(src->patch);
+                    if(dx < -32768 || dx > 32767 || dy < -32768 || dy > 32767 || z >= CompactNoIndex){
+                        ++overflows;
+                    }
+                    dst->dx = int16_t(dx);
+                    dst->dy = int16_t(dy);
+                    dst->index = z >= 0 ? uint16_t(z) : uint16_t(CompactNoIndex);
+                    dst->distance = quantizeDistance(src->distance);
+                }
+            }
+        }
+        return overflows == 0;
+    }
+
+    /**
+     * \brief Restore the k-NNF entries from their compact copy
+     *
+     * The entry order is kept, and so are the heaps.
+     */
+    template <int K, typename PatchData>
+    void expandEntries(const Mat &m, Mat &data) {
+        assert(m.elemSize() == sizeof(CompactEntry) * K && "Expanding a compact entry of invalid type");
+        assert(data.elemSize() == sizeof(PatchData) * K && "Expanding into an entry of invalid type");
+        assert(m.width == data.width && m.height == data.height && "Compact entry of invalid size");
+        const int h = data.height, w = data.width;
+#pragma omp parallel for
+        for(int y = 0; y < h; ++y){
+            const CompactEntry *src = m.ptr<CompactEntry>(y, 0);
+            PatchData *dst = data.ptr<PatchData>(y, 0);
+            for(int x = 0; x < w; ++x){
+                for(int k = 0; k < K; ++k, ++src, ++dst){
+                    dst->patch.x = x + src->dx;
+                    dst->patch.y = y + src->dy;
+                    setPatchIndex(dst->patch, src->index == CompactNoIndex ? -1 : int(src->index));
+                    dst->distance = expandDistance(src->distance);
+                }
+            }
+        }
+    }
+
+}
+
+#endif	/* NNF_COMPACT_H */
+
@@ -114,6 +114,7 @@ namespace pm {
 
             // create entry and insert
             Entry<T> entry(height, width);
+            assert(isAligned<T>(entry.ptr()) && "Field entry data is misaligned!");
             if(initialize){
                 // call default constructor for all the elements (placement-new)
                 // @see http://stackoverflow.com/questions/222557/what-uses-are-there-for-placement-new
@@ -122,7 +123,6 @@ namespace pm {
                 for(int i = 0, n = width * height; i < n; ++i){
                     new(&data[i])T();
                     // /!\ the destructors won't be called!
-                    // TODO check about alignment
                 }
             }
             
@@ -130,6 +130,19 @@ namespace pm {
             return entry;
         }
 
+        /**
+         * Replace the storage of an entry with existing data (e.g. a mapped file)
+         *
+         * The data is used as is (no constructor call), so T must be a POD type.
+         */
+        template < typename T >
+        Entry<T> attachEntry(const std::string &name, const Mat &m){
+            assert(m.width == width && m.height == height && "Attaching field entry of invalid size!");
+            Entry<T> entry(m);
+            entries[name] = entry;
+            return entry;
+        }
+
         template < typename T >
         Entry<T> getEntry(const std::string &name){
             auto it = entries.find(name);
@@ -155,6 +168,15 @@ namespace pm {
             return list;
         }
         
+        //! memory of the entries
+        size_t memory() const {
+            size_t bytes = 0;
+            for(const auto &e : entries){
+                bytes += e.second.memory();
+            }
+            return bytes;
+        }
+        
         template < typename T >
         struct EntryLayout {
             
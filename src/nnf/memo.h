@@ -0,0 +1,101 @@
+/*
+ * File:   memo.h
+ */
+
+#ifndef NNF_MEMO_H
+#define	NNF_MEMO_H
+
+#include "../math/point.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <stdint.h>
+
+// number of hashed slots per pixel (power of two)
+#ifndef PM_MEMO_SLOTS
+#define PM_MEMO_SLOTS 16
+#endif
+
+namespace pm {
+
+    /**
+     * \brief Per-pixel memo of the candidates rejected by kTryPatch
+     *
+     * During a scanline, the worst distance of a k-NNF heap can only
+     * decrease, so that a rejected candidate would be rejected again,
+     * and so would a patch evicted from the heap.
+     * Their hash is stored in one of the PM_MEMO_SLOTS slots of the pixel
+     * (direct-mapped, newer hashes replace older ones), and the next trials
+     * of these patches skip the distance evaluation.
+     * The memo is kept across the iterations, since propagation mostly
+     * proposes again the patches of the previous iterations.
+     *
+     * /!\ A different candidate with the same 32-bit hash is silently
+     * skipped as well, even if it would have improved the field.
+     *
+     * The memo must be cleared whenever the field changes outside of
+     * kTryPatch (initialization, loading, new source).
+     *
+     * A field uses a memo through a `RejectMemo *memo` member (NULL = none).
+     */
+    class RejectMemo {
+    public:
+        RejectMemo(int w, int h) : width(w), slots(size_t(w) * h * PM_MEMO_SLOTS, 0) {}
+
+        //! non-zero hash of a candidate patch
+        template <typename Patch>
+        static uint32_t hash(const Patch &q) {
+            unsigned char bytes[sizeof(Patch)];
+            std::memcpy(bytes, &q, sizeof(Patch));
+            uint32_t h = 2166136261u; // FNV-1a
+            for(size_t b = 0; b < sizeof(Patch); ++b){
+                h = (h ^ bytes[b]) * 16777619u;
+            }
+            // final mix for the slot bits
+            h ^= h >> 16;
+            h *= 0x85ebca6bu;
+            h ^= h >> 13;
+            return h ? h : 1;
+        }
+
+        inline bool rejected(const Point2i &i, uint32_t h) const {
+            return slots[index(i, h)] == h;
+        }
+        inline void reject(const Point2i &i, uint32_t h) {
+            slots[index(i, h)] = h;
+        }
+
+        void clear() {
+            std::fill(slots.begin(), slots.end(), 0);
+        }
+
+        inline size_t memory() const {
+            return slots.size() * sizeof(uint32_t);
+        }
+
+    private:
+        inline size_t index(const Point2i &i, uint32_t h) const {
+            return (size_t(i.y) * width + i.x) * PM_MEMO_SLOTS + (h >> 24) % PM_MEMO_SLOTS;
+        }
+
+        int width;
+        std::vector<uint32_t> slots;
+    };
+
+    //! memo of a field with a memo member
+    template <typename NNF>
+    inline auto rejectMemo(NNF *nnf, int) -> decltype(nnf->memo) {
+        return nnf->memo;
+    }
+    //! no memo for the other fields
+    template <typename NNF>
+    inline RejectMemo *rejectMemo(NNF *, long) {
+        return NULL;
+    }
+
+}
+
+#endif	/* NNF_MEMO_H */
+
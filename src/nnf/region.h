@@ -0,0 +1,74 @@
+/*
+ * File:   region.h
+ */
+
+#ifndef NNF_REGION_H
+#define	NNF_REGION_H
+
+#include "nnf.h"
+#include "../math/mask.h"
+#include "../scanline.h"
+
+namespace pm {
+
+    /**
+     * \brief Random initialization of the patches within a region
+     *
+     * The other entries of the field are left untouched.
+     *
+     * \return the number of initialized patches
+     */
+    template <typename Patch, typename DistValue, int K>
+    size_t initRegion(NearestNeighborField<Patch, DistValue, K> &nnf, const Mask &region) {
+        size_t n = 0;
+        for(const Point2i &i : nnf){
+            if(region.at<float>(i) == 0.0f) continue;
+            // same as a full initialization: K distinct entries
+            int k = nnf.init(i);
+            while(k < K) {
+                k += nnf.init(i);
+            }
+            ++n;
+        }
+        return n;
+    }
+
+    /**
+     * \brief Incremental update of a field after local changes of its source
+     *
+     * The patches overlapping dirty pixels are re-initialized, then the
+     * algorithm only runs on these patches and a halo around them, so that
+     * the propagation can bring good matches in from the untouched part of
+     * the field. Entries outside of that halo are not modified.
+     *
+     * The scanline still visits every index, but the filter skips the ones
+     * outside of the region before any distance computation, so that the
+     * cost scales with the size of the dirty region.
+     *
+     * \param dirty
+     *          pixel mask of the source changes (source size)
+     * \param halo
+     *          number of pixels to grow the processed region by
+     * \return the number of processed patches per iteration
+     */
+    template <typename Patch, typename DistValue, int K, typename Algorithm, typename IterationEnd>
+    size_t scanlineRegion(NearestNeighborField<Patch, DistValue, K> &nnf, const Mask &dirty, int halo, unsigned int numIters,
+            Algorithm &algo, IterationEnd &iterEnd) {
+        const int ps = Patch::width();
+        initRegion(nnf, patchRegion(dirty, nnf.height, nnf.width, ps, 0));
+        Mask region = patchRegion(dirty, nnf.height, nnf.width, ps, halo);
+        MaskFilter<Point2i, true> filter(region);
+        scanline(nnf, numIters, algo, filter, iterEnd);
+        return maskCount(region);
+    }
+
+    template <typename Patch, typename DistValue, int K, typename Algorithm>
+    size_t scanlineRegion(NearestNeighborField<Patch, DistValue, K> &nnf, const Mask &dirty, int halo, unsigned int numIters, Algorithm &algo) {
+        NoOp<uint> defaultIterEnd;
+        return scanlineRegion(nnf, dirty, halo, numIters, algo, defaultIterEnd);
+    }
+
+}
+
+#endif	/* NNF_REGION_H */
+
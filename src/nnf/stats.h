@@ -0,0 +1,66 @@
+/*
+ * File:   stats.h
+ */
+
+#ifndef NNF_STATS_H
+#define	NNF_STATS_H
+
+#include <chrono>
+#include <cstddef>
+
+// per-step statistics of VerboseAlgorithm (timings and patch trials)
+#ifndef PM_STEP_STATS
+#define PM_STEP_STATS 0
+#endif
+
+namespace pm {
+
+    /**
+     * \brief Statistics of an algorithm step
+     */
+    struct StepStats {
+        enum Field {
+            Time = 0,       //!< wall time (microseconds)
+            DistEvals,      //!< distance evaluations
+            EarlyOuts,      //!< candidates rejected by the field filter
+            Duplicates,     //!< candidates already present in the k-NNF or recently rejected
+            NumFields
+        };
+        size_t values[NumFields];
+
+        StepStats() {
+            reset();
+        }
+        inline void reset() {
+            for(int f = 0; f < NumFields; ++f){
+                values[f] = 0;
+            }
+        }
+        inline size_t &operator [](int f) {
+            return values[f];
+        }
+        inline size_t operator [](int f) const {
+            return values[f];
+        }
+    };
+
+    /**
+     * \brief Counters of the patch trials (see trypatch.h)
+     *
+     * They are only updated with PM_STEP_STATS, and are not thread-safe
+     * (the scanline traversal is sequential).
+     */
+    inline StepStats &trialCounters() {
+        static StepStats counters;
+        return counters;
+    }
+
+#if PM_STEP_STATS
+#define PM_COUNT_TRIAL(field) ++pm::trialCounters()[pm::StepStats::field]
+#else
+#define PM_COUNT_TRIAL(field)
+#endif
+
+}
+
+#endif	/* NNF_STATS_H */
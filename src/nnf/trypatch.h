@@ -8,22 +8,30 @@
 #ifndef TRYPATCH_H
 #define	TRYPATCH_H
 
+#include "memo.h"
 #include "nnf.h"
+#include "stats.h"
+
+#include <limits>
 
 namespace pm {
     
     template <typename TargetPatch = Patch2ti, typename DistValue = float>
     uint tryPatch(NearestNeighborField<TargetPatch, DistValue, 1> *nnf, const Point2i &i, const TargetPatch &q) {
         // filter patch based on location
-        if(nnf->filter(i, q))
+        if(nnf->filter(i, q)){
+            PM_COUNT_TRIAL(EarlyOuts);
             return 0;
+        }
         // check whether it's the same
         TargetPatch &p = nnf->patch(i);
         // if it's the same patch, too bad
         if(p == q){
+            PM_COUNT_TRIAL(Duplicates);
             return 0;
         }
         // compute distance for the new patch
+        PM_COUNT_TRIAL(DistEvals);
         DistValue newDist = nnf->dist(i, q);
         DistValue &curDist = nnf->distance(i);
 
@@ -38,21 +46,46 @@ namespace pm {
     template <int K = 7, typename TargetPatch = Patch2ti, typename DistValue = float>
     uint kTryPatch(NearestNeighborField<TargetPatch, DistValue, K> *nnf, const Point2i &i, const TargetPatch &q) {
         // filter patch based on location
-        if(nnf->filter(i, q))
+        if(nnf->filter(i, q)){
+            PM_COUNT_TRIAL(EarlyOuts);
             return 0;
+        }
         // check whether the patch is already present on the heap
         for(int k = 0; k < K; ++k){
             if(nnf->patch(i, k) == q
             && nnf->distance(i, k) < std::numeric_limits<DistValue>::max()){
+                PM_COUNT_TRIAL(Duplicates);
+                return 0;
+            }
+        }
+        // skip the patches already rejected or evicted (@see memo.h)
+        RejectMemo *memo = rejectMemo(nnf, 0);
+        uint32_t hash = 0;
+        if(memo){
+            hash = RejectMemo::hash(q);
+            if(memo->rejected(i, hash)){
+                PM_COUNT_TRIAL(Duplicates);
                 return 0;
             }
         }
         // compute distance for the new patch
+        PM_COUNT_TRIAL(DistEvals);
         DistValue newDist = nnf->dist(i, q);
         const DistValue &curDist = nnf->distance(i, 0); // worst distance
 
         if(newDist < curDist){
-            return nnf->store(i, q, newDist) ? 1 : 0;
+            // the evicted worst patch would be rejected from now on
+            const TargetPatch worst = nnf->patch(i, 0);
+            const bool worstSet = curDist < std::numeric_limits<DistValue>::max();
+            if(nnf->store(i, q, newDist)){
+                if(memo && worstSet){
+                    memo->reject(i, RejectMemo::hash(worst));
+                }
+                return 1;
+            }
+        }
+        if(memo){
+            memo->reject(i, hash);
         }
         return 0;
     }
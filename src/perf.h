@@ -0,0 +1,296 @@
+/*
+ * File:   perf.h
+ */
+
+#ifndef PERF_H
+#define	PERF_H
+
+// hardware counters around the hot stages (Linux perf_event_open)
+#ifndef PM_PERF_COUNTERS
+#define PM_PERF_COUNTERS 0
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#if PM_PERF_COUNTERS && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PM_PERF_EVENTS 1
+#if _OPENMP
+#include <omp.h>
+#endif
+#else
+#define PM_PERF_EVENTS 0
+#endif
+
+namespace pm {
+
+    /**
+     * \brief Counter values of one stage
+     */
+    struct PerfSample {
+        enum Event {
+            Cycles = 0,
+            Instructions,
+            L1DMisses,      //!< L1 data cache read misses
+            LLCMisses,      //!< last level cache read misses
+            BranchMisses,
+            NumEvents
+        };
+        double seconds;
+        uint64_t values[NumEvents];
+        bool available[NumEvents];
+
+        PerfSample() : seconds(0) {
+            for(int e = 0; e < NumEvents; ++e){
+                values[e] = 0;
+                available[e] = false;
+            }
+        }
+
+        static const char *name(int e) {
+            static const char *names[NumEvents] = {
+                "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+            };
+            return names[e];
+        }
+    };
+
+    /**
+     * \brief Hardware counters of the calling process
+     *
+     * Each event is opened on its own, so that the unavailable ones
+     * (no PMU, perf_event_paranoid, virtual machines...) are only reported
+     * as missing.
+     *
+     * A counter inherited by child threads only follows the threads created
+     * after it is opened, which misses an OpenMP pool started earlier (always
+     * the case within MATLAB). Instead, one set of counters is opened per
+     * thread of the OpenMP pool (found by running a parallel region of
+     * omp_get_max_threads() threads) and the stage values are their sum.
+     * The set of the calling thread is also inherited, so that the threads
+     * created afterwards (a larger pool) are still counted.
+     * Without PM_PERF_COUNTERS, only the wall time is measured.
+     */
+    class PerfCounters {
+    public:
+        PerfCounters() {
+#if PM_PERF_EVENTS
+            // thread ids of the pool (starting it if needed)
+            std::vector<pid_t> tids(1, pid_t(syscall(SYS_gettid)));
+#if _OPENMP
+            int threads = omp_get_max_threads();
+            std::vector<pid_t> pool(threads, 0);
+#pragma omp parallel num_threads(threads)
+            pool[omp_get_thread_num()] = pid_t(syscall(SYS_gettid));
+            for(pid_t tid : pool){
+                if(tid > 0 && std::find(tids.begin(), tids.end(), tid) == tids.end()){
+                    tids.push_back(tid);
+                }
+            }
+#endif
+            static const uint32_t types[PerfSample::NumEvents] = {
+                PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE
+            };
+            static const uint64_t configs[PerfSample::NumEvents] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                PERF_COUNT_HW_BRANCH_MISSES
+            };
+            for(int e = 0; e < PerfSample::NumEvents; ++e){
+                for(size_t t = 0; t < tids.size(); ++t){
+                    struct perf_event_attr attr;
+                    std::memset(&attr, 0, sizeof(attr));
+                    attr.size = sizeof(attr);
+                    attr.type = types[e];
+                    attr.config = configs[e];
+                    attr.disabled = 1;
+                    attr.inherit = t == 0; // threads created later by the caller
+                    attr.exclude_kernel = 1;
+                    attr.exclude_hv = 1;
+                    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                    int f = syscall(__NR_perf_event_open, &attr, tids[t], -1, -1, 0);
+                    if(f >= 0){
+                        fd[e].push_back(f);
+                    }
+                }
+            }
+#endif
+        }
+        ~PerfCounters() {
+#if PM_PERF_EVENTS
+            for(int e = 0; e < PerfSample::NumEvents; ++e){
+                for(int f : fd[e]){
+                    close(f);
+                }
+            }
+#endif
+        }
+
+        void start() {
+#if PM_PERF_EVENTS
+            for(int e = 0; e < PerfSample::NumEvents; ++e){
+                for(int f : fd[e]){
+                    ioctl(f, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(f, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+#endif
+            begin = std::chrono::steady_clock::now();
+        }
+
+        PerfSample stop() {
+            PerfSample s;
+            s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+#if PM_PERF_EVENTS
+            for(int e = 0; e < PerfSample::NumEvents; ++e){
+                for(int f : fd[e]){
+                    ioctl(f, PERF_EVENT_IOC_DISABLE, 0);
+                    uint64_t data[3]; // value, time enabled, time running
+                    // threads that did not run have no running time
+                    if(read(f, data, sizeof(data)) == sizeof(data) && data[2] > 0){
+                        s.available[e] = true;
+                        // scale if the counter was multiplexed
+                        s.values[e] += data[2] < data[1] ? uint64_t(double(data[0]) * data[1] / data[2]) : data[0];
+                    }
+                }
+            }
+#endif
+            return s;
+        }
+
+        //! number of threads followed
+        size_t threads() const {
+            return fd[PerfSample::Cycles].size();
+        }
+
+    private:
+        PerfCounters(const PerfCounters &);
+        PerfCounters &operator =(const PerfCounters &);
+
+        std::vector<int> fd[PerfSample::NumEvents];
+        std::chrono::steady_clock::time_point begin;
+    };
+
+    /**
+     * \brief Samples of the stages, by engine
+     */
+    struct PerfReport {
+        struct Entry {
+            std::string engine;
+            std::string stage;
+            PerfSample sample;
+        };
+        std::vector<Entry> entries;
+
+        void add(const std::string &engine, const std::string &stage, const PerfSample &s) {
+            Entry e;
+            e.engine = engine;
+            e.stage = stage;
+            e.sample = s;
+            entries.push_back(e);
+        }
+
+        //! CSV with NA for the unavailable counters
+        void write(std::ostream &out) const {
+            out << "engine,stage,seconds";
+            for(int e = 0; e < PerfSample::NumEvents; ++e){
+                out << "," << PerfSample::name(e);
+            }
+            out << "\n";
+            for(const Entry &entry : entries){
+                out << entry.engine << "," << entry.stage << "," << entry.sample.seconds;
+                for(int e = 0; e < PerfSample::NumEvents; ++e){
+                    if(entry.sample.available[e]){
+                        out << "," << entry.sample.values[e];
+                    } else {
+                        out << ",NA";
+                    }
+                }
+                out << "\n";
+            }
+        }
+    };
+
+    //! shared counters (opened on first use, outside of any parallel region)
+    inline PerfCounters &perfCounters() {
+        static PerfCounters counters;
+        return counters;
+    }
+
+    //! report of the process
+    inline PerfReport &perfReport() {
+        static PerfReport report;
+        return report;
+    }
+
+    /**
+     * \brief Sample a stage for the duration of the scope
+     *
+     * This is a no-op without PM_PERF_COUNTERS. Scopes must not be nested.
+     */
+    struct PerfScope {
+        PerfScope(const char *engine, const char *stage)
+#if PM_PERF_COUNTERS
+        : engineName(engine), stageName(stage) {
+            perfCounters().start();
+        }
+        ~PerfScope() {
+            perfReport().add(engineName, stageName, perfCounters().stop());
+        }
+    private:
+        const char *engineName;
+        const char *stageName;
+#else
+        {}
+#endif
+    };
+
+    /**
+     * \brief Scanline iteration end sampling each iteration
+     *
+     * start() must be called before the scanline, and stop() after it.
+     * This is a no-op without PM_PERF_COUNTERS.
+     */
+    struct PerfIterations {
+        explicit PerfIterations(const char *engine) : engineName(engine) {}
+
+        void start() {
+#if PM_PERF_COUNTERS
+            perfCounters().start();
+#endif
+        }
+        unsigned int operator()(int iter, bool) {
+#if PM_PERF_COUNTERS
+            std::stringstream stage;
+            stage << "iter" << iter;
+            perfReport().add(engineName, stage.str(), perfCounters().stop());
+            perfCounters().start();
+#endif
+            return 0;
+        }
+        void stop() {
+#if PM_PERF_COUNTERS
+            perfCounters().stop();
+#endif
+        }
+
+    private:
+        const char *engineName;
+    };
+
+}
+
+#endif	/* PERF_H */
@@ -8,6 +8,8 @@
 #ifndef SCANLINE_H
 #define	SCANLINE_H
 
+#include <iostream>
+
 typedef unsigned int uint;
 
 template< typename T, typename R = uint, R Result = 0 >
@@ -31,7 +33,6 @@ void scanline(Grid &grid, unsigned int numIters, Algorithm &algo, IterationFilte
 	bool rev = false;
 	for(unsigned int iter = 0; iter < numIters; ++iter){
 		bool done = true;
-        std::cout << "starting iter " << iter << "\n";
 		// scanline traversal
 		typename Grid::iterator it, end;
 		if(!rev){
@@ -0,0 +1,112 @@
+/*
+ * File:   gist_pack.cpp
+ */
+
+#include "gist/gist.h"
+#include "image/frames.h"
+#include "io/directory.h"
+#include "io/gistpack.h"
+#include "io/png.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace pm;
+
+void usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [-j threads] [-s size] [-m] image_dir [output]\n";
+    std::cerr << "  -j threads  number of worker threads (default: all cores)\n";
+    std::cerr << "  -s size     gist image size (default: 256)\n";
+    std::cerr << "  -m          mono exemplars (do not keep only the left frame)\n";
+    std::cerr << "  output      packed gist file (default: image_dir/.cache/gist.pack)\n";
+}
+
+/**
+ * Usage:
+ *
+ * gist_pack [-j threads] [-s size] [-m] image_dir [output]
+ *
+ * Computes the gist of every exemplar of a directory and writes them into
+ * a single packed file (@see io/gistpack.h, toolbox/load_gist_pack.m).
+ * The images that cannot be processed are left out of the pack.
+ */
+int main(int argc, char *argv[]) {
+    GistParams params;
+    bool stereo = true;
+    int threads = 0;
+    std::vector<std::string> args;
+    for(int i = 1; i < argc; ++i){
+        std::string arg(argv[i]);
+        if(arg == "-j" && i + 1 < argc){
+            threads = std::atoi(argv[++i]);
+        } else if(arg == "-s" && i + 1 < argc){
+            params.imageSize = std::atoi(argv[++i]);
+        } else if(arg == "-m"){
+            stereo = false;
+        } else if(arg == "-h" || arg == "--help"){
+            usage(argv[0]);
+            return 0;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if(args.empty() || args.size() > 2 || params.imageSize <= 0){
+        usage(argv[0]);
+        return 1;
+    }
+    const std::string dir = args[0];
+    const std::string output = args.size() > 1 ? args[1] : path::join(dir, ".cache/gist.pack");
+#ifdef _OPENMP
+    if(threads > 0){
+        omp_set_num_threads(threads);
+    }
+#endif
+
+    std::vector<std::string> files = findImages(dir);
+    if(files.empty()){
+        std::cerr << "No image found in " << dir << "\n";
+        return 1;
+    }
+
+    // filters are created once for all images
+    const GistExtractor extractor(params);
+    const int channels = 3; // png images are loaded as rgb
+    GistPack pack(files.size(), extractor.dimension(channels), channels);
+    std::vector<bool> valid(files.size(), true);
+    int failures = 0;
+
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < int(files.size()); ++i){
+        pack.names[i] = path::stem(files[i]);
+        try {
+            Image img = loadPNG(files[i]);
+            if(stereo){
+                img = leftFrame(img);
+            }
+            extractor.compute(img, pack.row(i));
+        } catch(const std::exception &e) {
+#pragma omp critical
+            {
+                std::cerr << "Could not process " << files[i] << ": " << e.what() << "\n";
+                valid[i] = false;
+                ++failures;
+            }
+        }
+    }
+
+    // no zero gist for the failed images (they would be selected as any other)
+    pack.keep(valid);
+    path::makeDirectories(output.substr(0, output.find_last_of('/') + 1));
+    if(!pack.save(output)){
+        std::cerr << "Could not write " << output << "\n";
+        return 1;
+    }
+    std::cout << "Packed " << pack.size() << " gists of dimension "
+              << pack.dimension << " into " << output << "\n";
+    return failures > 0 ? 2 : 0;
+}
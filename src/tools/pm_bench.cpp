@@ -0,0 +1,338 @@
+/*
+ * File:   pm_bench.cpp
+ */
+
+#define USE_MATLAB 0
+
+#include "impl/int_k_nnf.h"
+#include "impl/int_single_nnf.h"
+#include "impl/int_nnf_container.h"
+#include "math/imageset.h"
+#include "nnf/algorithm.h"
+#include "nnf/propagation.h"
+#include "nnf/trypatch.h"
+#include "nnf/uniformsearch.h"
+#include "voting/weighted_average.h"
+#include "scanline.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace pm;
+
+typedef NearestNeighborField<Patch2ti, float, 1> NNF;
+typedef NearestNeighborField<Patch2ti, float, 7> kNNF;
+
+void usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [-s height width] [-r reps] [-j threads] [-f format] [-o file]\n";
+    std::cerr << "  -s h w      size of the synthetic images (default: 240 320)\n";
+    std::cerr << "  -r reps     number of repetitions of each benchmark (default: 3)\n";
+    std::cerr << "  -j threads  number of threads for the vote (default: all cores)\n";
+    std::cerr << "  -f format   csv (default) or json\n";
+    std::cerr << "  -o file     output file (default: standard output)\n";
+}
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    //! results of the timed loops (so that they are not optimized away)
+    volatile float sink;
+
+    /**
+     * Benchmark results, printed as they come
+     */
+    struct Report {
+        std::ostream &out;
+        bool json;
+        bool first;
+
+        Report(std::ostream &o, bool j) : out(o), json(j), first(true) {
+            if(json){
+                out << "[\n";
+            } else {
+                out << "benchmark,channels,patch_size,ops,ns_per_op,pixels_per_s\n";
+            }
+        }
+        ~Report() {
+            if(json){
+                out << "\n]\n";
+            }
+        }
+
+        /**
+         * \param ops
+         *          number of operations timed
+         * \param pixels
+         *          number of pixels processed by these operations
+         */
+        void add(const std::string &name, int channels, int patchSize, double ops, double pixels, double seconds) {
+            double nsPerOp = seconds * 1e9 / ops;
+            double pixPerSec = pixels / seconds;
+            if(json){
+                out << (first ? "" : ",\n");
+                out << "  {\"benchmark\": \"" << name << "\", \"channels\": " << channels
+                          << ", \"patch_size\": " << patchSize << ", \"ops\": " << ops
+                          << ", \"ns_per_op\": " << nsPerOp << ", \"pixels_per_s\": " << pixPerSec << "}";
+            } else {
+                out << name << "," << channels << "," << patchSize << "," << ops << ","
+                          << nsPerOp << "," << pixPerSec << "\n";
+            }
+            out.flush();
+            first = false;
+        }
+    };
+
+    inline double since(const Clock::time_point &start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    //! random image with values in [0;255]
+    Image randomImage(int h, int w, int channels) {
+        Image img(h, w, IM_32FC(channels));
+        float *data = reinterpret_cast<float *>(img.ptr());
+        for(int i = 0, n = h * w * channels; i < n; ++i){
+            data[i] = unif01() * 255.0f;
+        }
+        return img;
+    }
+
+    //! smooth gradient image (for the searches to converge to something)
+    Image gradientImage(int h, int w, float phase) {
+        Image img(h, w, IM_32FC3);
+        for(const Point2i &i : img){
+            Vec3f &v = img.at<Vec3f>(i);
+            v[0] = 127.5f + 127.5f * std::sin(0.05f * i.x + phase);
+            v[1] = 127.5f + 127.5f * std::cos(0.07f * i.y - phase);
+            v[2] = 0.5f * (v[0] + v[1]);
+        }
+        return img;
+    }
+
+    template <int channels>
+    void benchSSD(Report &report, int h, int w, int reps) {
+        Image source = randomImage(h, w, channels);
+        Image target = randomImage(h, w, channels);
+        const int sizes[] = { 5, 7, 9, 11 };
+        for(int s = 0; s < 4; ++s){
+            Patch2ti::width(sizes[s]);
+            DistanceFunc d = &dist::SumSquaredDiff<Patch2ti, float, Image, channels>;
+            const int ph = h - sizes[s] + 1, pw = w - sizes[s] + 1;
+            const int N = std::max(1, 1000000 / (sizes[s] * sizes[s]));
+            // random pairs of patches
+            std::vector<Patch2ti> p(N), q(N);
+            for(int i = 0; i < N; ++i){
+                p[i] = Patch2ti(Point2i(unif01() * pw, unif01() * ph));
+                q[i] = Patch2ti(Point2i(unif01() * pw, unif01() * ph));
+            }
+            float sum = 0.0f;
+            Clock::time_point start = Clock::now();
+            for(int r = 0; r < reps; ++r){
+                for(int i = 0; i < N; ++i){
+                    sum += d(source, target, p[i], q[i]);
+                }
+            }
+            double t = since(start);
+            double ops = double(N) * reps;
+            sink = sum;
+            report.add("ssd", channels, sizes[s], ops, ops * sizes[s] * sizes[s], t);
+        }
+    }
+
+    /**
+     * SumSquaredDiff against an image set (as the ix k-NNF),
+     * with row-major targets or column-major views (as Matlab arrays)
+     */
+    template <int channels>
+    void benchSetSSD(Report &report, int h, int w, int reps) {
+        Image source = randomImage(h, w, channels);
+        ImageSet rowMajor(2), colMajor(2);
+        for(int n = 0; n < 2; ++n){
+            rowMajor[n] = randomImage(h, w, channels);
+            DataPtr planes(new byte[size_t(h) * w * channels * sizeof(float)]);
+            std::memcpy(planes.get(), rowMajor[n].ptr(), size_t(h) * w * channels * sizeof(float));
+            colMajor[n] = Mat::columnMajor(h, w, IM_32FC(channels), planes);
+        }
+        Patch2ti::width(7);
+        Distance<Patch2tix, float, ImageSet> d = &dist::SumSquaredDiff<Patch2tix, float, ImageSet, channels>;
+        const int ph = h - 6, pw = w - 6;
+        const int N = 1000000 / 49;
+        std::vector<Patch2ti> p(N);
+        std::vector<Patch2tix> q(N);
+        for(int i = 0; i < N; ++i){
+            p[i] = Patch2ti(Point2i(unif01() * pw, unif01() * ph));
+            q[i] = Patch2tix(Point2i(unif01() * pw, unif01() * ph), i % 2);
+        }
+        for(int layout = 0; layout < 2; ++layout){
+            const ImageSet &targets = layout == IM_ROW_MAJOR ? rowMajor : colMajor;
+            float sum = 0.0f;
+            Clock::time_point start = Clock::now();
+            for(int r = 0; r < reps; ++r){
+                for(int i = 0; i < N; ++i){
+                    sum += d(source, targets, p[i], q[i]);
+                }
+            }
+            double t = since(start);
+            double ops = double(N) * reps;
+            sink = sum;
+            report.add(layout == IM_ROW_MAJOR ? "ssd_set" : "ssd_set_colmajor", channels, 7, ops, ops * 49, t);
+        }
+    }
+
+    void benchHeap(Report &report, int reps) {
+        typedef kNNF::PatchData PatchData;
+        const int N = 1000000;
+        std::vector<float> dists(N);
+        for(int i = 0; i < N; ++i){
+            dists[i] = unif01();
+        }
+        PatchData data[7];
+        kNNF::MaxHeap heap(data);
+        int inserted = 0;
+        Clock::time_point start = Clock::now();
+        for(int r = 0; r < reps; ++r){
+            for(int k = 0; k < 7; ++k){
+                data[k] = PatchData();
+            }
+            for(int i = 0; i < N; ++i){
+                inserted += heap.insert(PatchData(Patch2ti(), dists[i])) ? 1 : 0;
+            }
+        }
+        double t = since(start);
+        sink = inserted;
+        report.add("heap_insert", 0, 0, double(N) * reps, 0.0, t);
+    }
+
+    void benchSearch(Report &report, int h, int w, int reps) {
+        Patch2ti::width(7);
+        Image source = gradientImage(h, w, 0.0f);
+        Image target = gradientImage(h, w, 1.0f);
+        DistanceFunc d = DistanceFactory<Patch2ti, float>::get(dist::SSD, 3);
+        kNNF nnf(source, target, d);
+        for(const Point2i &i : nnf){
+            nnf.init(i);
+        }
+        const double patches = double(nnf.width) * nnf.height;
+
+        // kTryPatch over random candidates
+        std::vector<Patch2ti> cands(nnf.width * nnf.height);
+        for(size_t i = 0; i < cands.size(); ++i){
+            cands[i] = Patch2ti(Point2i(unif01() * nnf.width, unif01() * nnf.height));
+        }
+        uint success = 0;
+        Clock::time_point start = Clock::now();
+        for(int r = 0; r < reps; ++r){
+            size_t c = 0;
+            for(const Point2i &i : nnf){
+                success += kTryPatch<7, Patch2ti, float>(&nnf, i, cands[c++]);
+            }
+        }
+        double t = since(start);
+        sink = success;
+        report.add("k_try_patch", 3, 7, patches * reps, patches * reps * 49, t);
+
+        // one scanline iteration of search + propagation
+        auto seq = Algorithm() << UniformSearch<Patch2ti, float, 7>(&nnf) << Propagation<Patch2ti, float, 7>(&nnf);
+        start = Clock::now();
+        for(int r = 0; r < reps; ++r){
+            scanline(nnf, 1, seq);
+        }
+        t = since(start);
+        report.add("scanline_iter", 3, 7, double(reps), double(source.width) * source.height * reps, t);
+    }
+
+    void benchVote(Report &report, int h, int w, int reps) {
+        Patch2ti::width(7);
+        Image source = randomImage(h, w, 3);
+        Image target = randomImage(h, w, 3);
+        DistanceFunc d = DistanceFactory<Patch2ti, float>::get(dist::SSD, 3);
+        NNF nnf(source, target, d);
+        for(const Point2i &i : nnf){
+            nnf.init(i);
+        }
+        Filter filter(7);
+        PixelContainer<3, Patch2ti, float> data(&nnf);
+        Clock::time_point start = Clock::now();
+        for(int r = 0; r < reps; ++r){
+            Image vote = weighted_average(data, filter);
+        }
+        double t = since(start);
+        report.add("weighted_average", 3, 7, double(reps), double(w) * h * reps, t);
+    }
+
+}
+
+/**
+ * Usage:
+ *
+ * pm_bench [-s height width] [-r reps] [-j threads] [-f format] [-o file]
+ *
+ * Microbenchmarks of the PatchMatch kernels on synthetic images:
+ * SumSquaredDiff per channel count and patch size, SumSquaredDiff against
+ * an image set (row-major or column-major targets), Heap::insert,
+ * kTryPatch, one scanline iteration and weighted_average.
+ * Each line reports the ns per operation and the pixels per second.
+ */
+int main(int argc, char *argv[]) {
+    int h = 240, w = 320;
+    int reps = 3;
+    int threads = 0;
+    bool json = false;
+    std::string output;
+    for(int i = 1; i < argc; ++i){
+        std::string arg(argv[i]);
+        if(arg == "-s" && i + 2 < argc){
+            h = std::atoi(argv[++i]);
+            w = std::atoi(argv[++i]);
+        } else if(arg == "-r" && i + 1 < argc){
+            reps = std::atoi(argv[++i]);
+        } else if(arg == "-j" && i + 1 < argc){
+            threads = std::atoi(argv[++i]);
+        } else if(arg == "-f" && i + 1 < argc){
+            json = std::string(argv[++i]) == "json";
+        } else if(arg == "-o" && i + 1 < argc){
+            output = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(h < 16 || w < 16 || reps < 1){
+        std::cerr << "Invalid size or number of repetitions.\n";
+        return 1;
+    }
+#ifdef _OPENMP
+    if(threads > 0){
+        omp_set_num_threads(threads);
+    }
+#endif
+    seed(0);
+
+    std::ofstream file;
+    if(!output.empty()){
+        file.open(output.c_str());
+        if(!file){
+            std::cerr << "Cannot write to " << output << "\n";
+            return 1;
+        }
+    }
+    Report report(output.empty() ? std::cout : file, json);
+    benchSSD<1>(report, h, w, reps);
+    benchSSD<3>(report, h, w, reps);
+    benchSSD<4>(report, h, w, reps);
+    benchSSD<8>(report, h, w, reps);
+    benchSetSSD<3>(report, h, w, reps);
+    benchHeap(report, reps);
+    benchSearch(report, h, w, reps);
+    benchVote(report, h, w, reps);
+    return 0;
+}
@@ -0,0 +1,453 @@
+/*
+ * File:   pm_quality.cpp
+ */
+
+#define USE_MATLAB 0
+
+#include "impl/ix_k_nnf.h"
+#include "impl/k_disp.h"
+#include "image/resize.h"
+#include "io/png.h"
+#include "nnf/algorithm.h"
+#include "nnf/horizontalsearch.h"
+#include "nnf/horizontalrandsearch.h"
+#include "nnf/localmean.h"
+#include "nnf/propagation.h"
+#include "nnf/randpropagation.h"
+#include "nnf/uniformsearch.h"
+#include "perf.h"
+#include "scanline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+using namespace pm;
+
+#define KNNF_K 7
+
+typedef NearestNeighborField<Patch2tix, float, KNNF_K> IxNNF;
+typedef NearestNeighborField<Patch2tf, float, KNNF_K> DispNNF;
+
+void usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [-d data_dir] [-s width] [-p size] [-i iters] [-r seeds] [-y max_dy] [-o file]\n";
+    std::cerr << "  -d dir      directory of the test images a.png, b.png, B.png (default: tests/data)\n";
+    std::cerr << "  -s width    width the images are resized to (default: 80)\n";
+    std::cerr << "  -p size     patch size (default: 7)\n";
+    std::cerr << "  -i iters    comma-separated iteration budgets (default: 1,2,4,6,8)\n";
+    std::cerr << "  -r seeds    number of random seeds per budget (default: 2)\n";
+    std::cerr << "  -y max_dy   vertical range of the disparity search (default: 5)\n";
+    std::cerr << "  -o file     output file (default: standard output)\n";
+}
+
+namespace {
+
+    typedef std::chrono::steady_clock Clock;
+
+    //! number of distance evaluations since the last reset (searches are serial)
+    uint64_t distEvals = 0;
+
+    //! SSD counting its evaluations
+    template <typename Patch, typename Img>
+    float countedSSD(const Image &source, const Img &target,
+            const typename Patch::SourcePatch &p1, const Patch &p2) {
+        ++distEvals;
+        return dist::SumSquaredDiff<Patch, float, Img, 3>(source, target, p1, p2);
+    }
+
+    /**
+     * Exact neighbor of a query patch
+     */
+    struct Neighbor {
+        float distance;
+        int x, y, z;
+
+        Neighbor(float d, int px, int py, int pz) : distance(d), x(px), y(py), z(pz) {}
+        bool operator <(const Neighbor &n) const {
+            return distance < n.distance;
+        }
+    };
+    typedef std::vector<Neighbor> Neighbors;
+
+    //! keep the K best of a max-heap
+    inline void keepBest(Neighbors &heap, const Neighbor &n) {
+        if(heap.size() < KNNF_K){
+            heap.push_back(n);
+            std::push_heap(heap.begin(), heap.end());
+        } else if(n < heap.front()){
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = n;
+            std::push_heap(heap.begin(), heap.end());
+        }
+    }
+
+    /**
+     * Quality of a k-NNF against the exact neighbors
+     */
+    struct Quality {
+        double recall;      //!< mean fraction of the exact K found
+        double distRatio;   //!< ratio of the found over the exact distances
+        double bestRatio;   //!< ratio of the found over the exact best distances
+
+        Quality() : recall(0), distRatio(0), bestRatio(0) {}
+    };
+
+    /**
+     * \brief Recall@K and distance ratio of a k-NNF
+     *
+     * Each exact neighbor can only be matched once (sub-pixel entries around
+     * the same position do not count multiple times).
+     * The distance ratio is over the whole field and only uses the pixels
+     * whose K entries are all valid. It can be below 1 for sub-pixel searches,
+     * whose entries are not restricted to the integer positions.
+     */
+    template <typename NNF, typename Match>
+    Quality quality(const NNF &nnf, const std::vector<Neighbors> &exact, const Match &match) {
+        Quality q;
+        int n = 0;
+        double sumFound = 0.0, sumExact = 0.0, sumBest = 0.0, sumExactBest = 0.0;
+        for(const Point2i &i : nnf){
+            const Neighbors &ex = exact[nnf.width * i.y + i.x];
+            std::vector<bool> used(ex.size(), false);
+            int found = 0, finite = 0;
+            double foundDist = 0.0, exactDist = 0.0;
+            float best = std::numeric_limits<float>::max();
+            for(int k = 0; k < KNNF_K; ++k){
+                const float d = nnf.distance(i, k);
+                if(d < std::numeric_limits<float>::max()){
+                    foundDist += d;
+                    ++finite;
+                    best = std::min(best, d);
+                }
+                for(size_t e = 0; e < ex.size(); ++e){
+                    if(!used[e] && match(nnf.patch(i, k), ex[e])){
+                        used[e] = true;
+                        ++found;
+                        break;
+                    }
+                }
+                exactDist += ex[k].distance;
+            }
+            q.recall += double(found) / KNNF_K;
+            if(finite == KNNF_K){
+                sumFound += foundDist;
+                sumExact += exactDist;
+                sumBest += best;
+                sumExactBest += ex[0].distance;
+            }
+            ++n;
+        }
+        q.recall /= std::max(n, 1);
+        q.distRatio = sumExact > 0.0 ? sumFound / sumExact : 1.0;
+        q.bestRatio = sumExactBest > 0.0 ? sumBest / sumExactBest : 1.0;
+        return q;
+    }
+
+    struct IxMatch {
+        bool operator()(const Patch2tix &p, const Neighbor &n) const {
+            return p.x == n.x && p.y == n.y && p.z == n.z;
+        }
+    };
+
+    struct DispMatch {
+        //! sub-pixel patches match their nearest integer position
+        bool operator()(const Patch2tf &p, const Neighbor &n) const {
+            return int(std::floor(p.x + 0.5f)) == n.x && int(std::floor(p.y + 0.5f)) == n.y;
+        }
+    };
+
+    //! exact k-NN over all the positions of all the exemplars (in parallel, nnf.dist must be thread-safe)
+    std::vector<Neighbors> exactIx(const IxNNF &nnf) {
+        std::vector<Neighbors> exact(nnf.width * nnf.height);
+        const int P = Patch2tix::width();
+#if _OPENMP
+#pragma omp parallel for
+#endif
+        for(int y = 0; y < nnf.height; ++y){
+            for(int x = 0; x < nnf.width; ++x){
+                Neighbors &heap = exact[nnf.width * y + x];
+                for(int z = 0, Z = nnf.targets.size(); z < Z; ++z){
+                    for(int ty = 0; ty + P <= nnf.targets[z].height; ++ty){
+                        for(int tx = 0; tx + P <= nnf.targets[z].width; ++tx){
+                            Patch2tix q(Point2i(tx, ty), z);
+                            keepBest(heap, Neighbor(nnf.dist(Point2i(x, y), q), tx, ty, z));
+                        }
+                    }
+                }
+                std::sort_heap(heap.begin(), heap.end());
+            }
+        }
+        return exact;
+    }
+
+    //! exact k-NN over the integer positions allowed by the disparity filter (same as exactIx)
+    std::vector<Neighbors> exactDisp(const DispNNF &nnf) {
+        std::vector<Neighbors> exact(nnf.width * nnf.height);
+        const int P = Patch2tf::width();
+#if _OPENMP
+#pragma omp parallel for
+#endif
+        for(int y = 0; y < nnf.height; ++y){
+            for(int x = 0; x < nnf.width; ++x){
+                Neighbors &heap = exact[nnf.width * y + x];
+                int y0 = std::max(0, y - nnf.maxDY), y1 = std::min(nnf.target.height - P, y + nnf.maxDY);
+                for(int ty = y0; ty <= y1; ++ty){
+                    for(int tx = 0; tx + P <= nnf.target.width; ++tx){
+                        Patch2tf q(Point2f(tx, ty));
+                        keepBest(heap, Neighbor(nnf.dist(Point2i(x, y), q), tx, ty, 0));
+                    }
+                }
+                std::sort_heap(heap.begin(), heap.end());
+            }
+        }
+        return exact;
+    }
+
+    /**
+     * Results, one CSV line per run
+     */
+    struct Report {
+        std::ostream &out;
+
+        explicit Report(std::ostream &o) : out(o) {
+            out << "engine,dataset,exemplars,iterations,seed,time_s,dist_evals,recall_at_k,dist_ratio,best_ratio\n";
+        }
+
+        void add(const std::string &engine, const std::string &dataset, int exemplars,
+                int iters, int seed, double seconds, uint64_t evals, const Quality &q) {
+            out << engine << "," << dataset << "," << exemplars << "," << iters << "," << seed << ","
+                << seconds << "," << evals << "," << q.recall << "," << q.distRatio << "," << q.bestRatio << "\n";
+            out.flush();
+        }
+    };
+
+    inline double since(const Clock::time_point &start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /**
+     * \brief Run the ixknnf search (uniform search + propagation) with different budgets
+     *
+     * A single exemplar gives the same search as iknnf, but through the
+     * ix engine, so that its rows are also labeled ixknnf (exemplars = 1).
+     */
+    void runIx(Report &report, const std::string &dataset,
+            const Image &query, const ImageSet &exemplars, const std::vector<int> &budgets, int seeds) {
+        // the brute force runs in parallel, without counting
+        IxNNF ref(query, exemplars, &dist::SumSquaredDiff<Patch2tix, float, ImageSet, 3>);
+        std::vector<Neighbors> exact = exactIx(ref);
+        for(size_t b = 0; b < budgets.size(); ++b){
+            for(int s = 0; s < seeds; ++s){
+                seed(s + 1);
+                distEvals = 0;
+                Clock::time_point start = Clock::now();
+                IxNNF nnf(query, exemplars, &countedSSD<Patch2tix, ImageSet>);
+                {
+                    PerfScope perf("ixknnf", "init");
+                    for(const Point2i &i : nnf){
+                        nnf.init(i);
+                    }
+                }
+                auto seq = Algorithm()  << UniformSearch<Patch2tix, float, KNNF_K>(&nnf)
+                                        << Propagation<Patch2tix, float, KNNF_K>(&nnf);
+                NoOp<Point2i> filter;
+                PerfIterations iterEnd("ixknnf");
+                iterEnd.start();
+                scanline(nnf, budgets[b], seq, filter, iterEnd);
+                iterEnd.stop();
+                double t = since(start);
+                report.add("ixknnf", dataset, exemplars.size(), budgets[b], s + 1, t, distEvals, quality(nnf, exact, IxMatch()));
+            }
+        }
+    }
+
+    /**
+     * \brief Run the fkdisp search (same sequence as the mex) with different budgets
+     */
+    void runDisp(Report &report, const std::string &dataset, const Image &left, const Image &right,
+            int maxDY, const std::vector<int> &budgets, int seeds) {
+        BilinearMatF source(left), target(right);
+        DispNNF ref(source, target, &dist::SumSquaredDiff<Patch2tf, float, BilinearMatF, 3>, maxDY);
+        std::vector<Neighbors> exact = exactDisp(ref);
+        for(size_t b = 0; b < budgets.size(); ++b){
+            for(int s = 0; s < seeds; ++s){
+                seed(s + 1);
+                distEvals = 0;
+                Clock::time_point start = Clock::now();
+                DispNNF nnf(source, target, &countedSSD<Patch2tf, BilinearMatF>, maxDY);
+                {
+                    PerfScope perf("fkdisp", "init");
+                    for(const Point2i &i : nnf){
+                        nnf.init(i);
+                    }
+                }
+                SearchRadius<float> search;
+                search.radius = std::max(target.width, target.height) / 2.0f;
+                search.minimum = float(Patch2tf::width());
+                auto seq = Algorithm() << HorizontalSearch<Patch2tf, float, KNNF_K>(&nnf)
+                                       << HorizontalRandomSearch<Patch2tf, float, KNNF_K>(&nnf, &search, maxDY)
+                                       << Propagation<Patch2tf, float, KNNF_K>(&nnf)
+                                       << RandomPropagation<Patch2tf, float, KNNF_K>(&nnf)
+                                       << LocalMean<Patch2tf, float, KNNF_K, 4>(&nnf)
+                                       << LocalMean<Patch2tf, float, KNNF_K, 8>(&nnf)
+                                       << LocalMean<Patch2tf, float, KNNF_K, 16>(&nnf);
+                NoOp<Point2i, bool, false> filter;
+                PerfIterations iterEnd("fkdisp");
+                auto post = PostSequence() << DecreasingSearchRadius<float>(&search) << std::ref(iterEnd);
+                iterEnd.start();
+                scanline(nnf, budgets[b], seq, filter, post);
+                iterEnd.stop();
+                double t = since(start);
+                report.add("fkdisp", dataset, 1, budgets[b], s + 1, t, distEvals, quality(nnf, exact, DispMatch()));
+            }
+        }
+    }
+
+    //! smooth random texture (sum of random sinusoids and noise)
+    Image texture(int h, int w) {
+        float fx[4], fy[4], ph[4];
+        for(int j = 0; j < 4; ++j){
+            fx[j] = 0.05f + 0.4f * unif01();
+            fy[j] = 0.05f + 0.4f * unif01();
+            ph[j] = 6.28f * unif01();
+        }
+        Image img(h, w, IM_32FC3);
+        for(const Point2i &i : img){
+            Vec3f &v = img.at<Vec3f>(i);
+            for(int c = 0; c < 3; ++c){
+                const int j = (c + 1) % 4;
+                v[c] = 0.5f + 0.2f * std::sin(fx[c] * i.x + fy[j] * i.y + ph[c])
+                            + 0.2f * std::cos(fx[j] * i.x - fy[c] * i.y + ph[j])
+                            + 0.1f * unif01();
+            }
+        }
+        return img;
+    }
+
+    //! right view of a left image, with a disparity growing from d0 (top) to d1 (bottom)
+    Image shifted(const Image &left, float d0, float d1) {
+        Image right(left.height, left.width, IM_32FC3);
+        for(const Point2i &i : right){
+            float d = d0 + (d1 - d0) * i.y / std::max(1, left.height - 1);
+            float x = std::min(std::max(i.x + d, 0.0f), left.width - 1.0f);
+            right.at<Vec3f>(i) = bilinearLookup<Vec3f, float>(left, Point2f(x, i.y));
+        }
+        return right;
+    }
+
+    Image loadResized(const std::string &fname, int width) {
+        Image img = loadPNG(fname);
+        int height = std::max(1, int(img.height * float(width) / img.width + 0.5f));
+        return resize(img, height, width);
+    }
+
+}
+
+/**
+ * Usage:
+ *
+ * pm_quality [-d data_dir] [-s width] [-p size] [-i iters] [-r seeds] [-y max_dy] [-o file]
+ *
+ * Accuracy vs throughput of the PatchMatch searches against the exact k-NN
+ * found by brute force, on small images (the test images and a synthetic
+ * stereo set). For each engine and iteration budget, it reports the wall
+ * time, the number of distance evaluations, the recall@K and the ratios
+ * of the found over the exact distances, for all K and for the best entry
+ * (1 = exact, below 1 when sub-pixel entries beat the integer positions).
+ */
+int main(int argc, char *argv[]) {
+    std::string dataDir = "tests/data";
+    std::string output;
+    int width = 80;
+    int patchSize = 7;
+    int seeds = 2;
+    int maxDY = 5;
+    std::vector<int> budgets;
+    for(int i = 1; i < argc; ++i){
+        std::string arg(argv[i]);
+        bool hasValue = i + 1 < argc;
+        if(arg == "-d" && hasValue){
+            dataDir = argv[++i];
+        } else if(arg == "-s" && hasValue){
+            width = std::atoi(argv[++i]);
+        } else if(arg == "-p" && hasValue){
+            patchSize = std::atoi(argv[++i]);
+        } else if(arg == "-i" && hasValue){
+            std::stringstream ss(argv[++i]);
+            std::string item;
+            while(std::getline(ss, item, ',')){
+                budgets.push_back(std::atoi(item.c_str()));
+            }
+        } else if(arg == "-r" && hasValue){
+            seeds = std::atoi(argv[++i]);
+        } else if(arg == "-y" && hasValue){
+            maxDY = std::atoi(argv[++i]);
+        } else if(arg == "-o" && hasValue){
+            output = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(budgets.empty()){
+        const int defaults[] = { 1, 2, 4, 6, 8 };
+        budgets.assign(defaults, defaults + 5);
+    }
+    if(width < 2 * patchSize || patchSize < 1 || seeds < 1){
+        std::cerr << "Invalid image width, patch size or number of seeds.\n";
+        return 1;
+    }
+    Patch2tix::width(patchSize);
+    Patch2tf::width(patchSize);
+
+    std::ofstream file;
+    if(!output.empty()){
+        file.open(output.c_str());
+        if(!file){
+            std::cerr << "Cannot write to " << output << "\n";
+            return 1;
+        }
+    }
+    Report report(output.empty() ? std::cout : file);
+
+    // test images: a / b as stereo pair, b and B as exemplars of a
+    Image a, b, B;
+    try {
+        a = loadResized(dataDir + "/a.png", width);
+        b = loadResized(dataDir + "/b.png", width);
+        B = loadResized(dataDir + "/B.png", width);
+    } catch(std::exception &e) {
+        std::cerr << "Cannot load the test images: " << e.what() << "\n";
+        return 1;
+    }
+    ImageSet single(1), pair(2);
+    single[0] = b;
+    pair[0] = b;
+    pair[1] = B;
+    runIx(report, "tests", a, single, budgets, seeds);
+    runIx(report, "tests", a, pair, budgets, seeds);
+    runDisp(report, "tests", a, b, maxDY, budgets, seeds);
+
+    // synthetic stereo set: one textured view, exemplars with different disparities
+    seed(0);
+    const int height = std::max(2 * patchSize, width * 9 / 16);
+    Image left = texture(height, width);
+    ImageSet rights(3);
+    for(int z = 0; z < 3; ++z){
+        rights[z] = shifted(left, 2.0f + 2 * z, 6.0f + 2 * z);
+    }
+    runIx(report, "synthetic", left, rights, budgets, seeds);
+    runDisp(report, "synthetic", left, rights[0], maxDY, budgets, seeds);
+#if PM_PERF_COUNTERS
+    // stage counters of all the runs (make quality PERF=1)
+    perfReport().write(std::cerr);
+#endif
+    return 0;
+}
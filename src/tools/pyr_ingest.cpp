@@ -0,0 +1,142 @@
+/*
+ * File:   pyr_ingest.cpp
+ */
+
+#include "image/frames.h"
+#include "image/pyramid.h"
+#include "io/cache.h"
+#include "io/directory.h"
+#include "io/matfile.h"
+#include "io/png.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace pm;
+
+void usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [-j threads] [-t type] [-l levels] [-f] [-b] image_dir [cache_dir]\n";
+    std::cerr << "  -j threads  number of worker threads (default: all cores)\n";
+    std::cerr << "  -t type     laplacian (default) or gaussian\n";
+    std::cerr << "  -l levels   number of pyramid reductions (default: from the image size)\n";
+    std::cerr << "  -f          recompute pyramids that are already cached\n";
+    std::cerr << "  -b          write one binary cache file per exemplar (<name>.pmc) instead of mat files\n";
+    std::cerr << "  cache_dir   the cache directory (default: image_dir/.cache)\n";
+}
+
+std::string levelFile(const std::string &cacheDir, const std::string &pyrDir, int level, const std::string &name) {
+    std::stringstream ss;
+    ss << level;
+    return path::join(path::join(path::join(cacheDir, pyrDir), ss.str()), name + ".mat");
+}
+
+/**
+ * Usage:
+ *
+ * pyr_ingest [-j threads] [-t type] [-l levels] [-f] [-b] image_dir [cache_dir]
+ *
+ * Builds the left-frame pyramid of every exemplar of a directory and stores
+ * its levels in the cache layout of toolbox/stereo_synth.m, i.e.
+ * cache_dir/{gpyr,lpyr}/<level>/<name>.mat with level 1 = coarsest,
+ * or cache_dir/{gpyr,lpyr}/<name>.pmc with all the levels (@see io/cache.h).
+ */
+int main(int argc, char *argv[]) {
+    std::string type = "laplacian";
+    int levels = -1;
+    int threads = 0;
+    bool force = false;
+    bool binary = false;
+    std::vector<std::string> args;
+    for(int i = 1; i < argc; ++i){
+        std::string arg(argv[i]);
+        if(arg == "-j" && i + 1 < argc){
+            threads = std::atoi(argv[++i]);
+        } else if(arg == "-t" && i + 1 < argc){
+            type = argv[++i];
+        } else if(arg == "-l" && i + 1 < argc){
+            levels = std::atoi(argv[++i]);
+        } else if(arg == "-f"){
+            force = true;
+        } else if(arg == "-b"){
+            binary = true;
+        } else if(arg == "-h" || arg == "--help"){
+            usage(argv[0]);
+            return 0;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if(args.empty() || args.size() > 2 || (type != "laplacian" && type != "gaussian")){
+        usage(argv[0]);
+        return 1;
+    }
+    const std::string dir = args[0];
+    const std::string cacheDir = args.size() > 1 ? args[1] : path::join(dir, ".cache");
+    const std::string pyrDir = type == "gaussian" ? "gpyr" : "lpyr";
+#ifdef _OPENMP
+    if(threads > 0){
+        omp_set_num_threads(threads);
+    }
+#endif
+
+    std::vector<std::string> files = findImages(dir);
+    if(files.empty()){
+        std::cerr << "No image found in " << dir << "\n";
+        return 1;
+    }
+
+    int failures = 0, skipped = 0;
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < int(files.size()); ++i){
+        const std::string name = path::stem(files[i]);
+        // same check as stereo_synth: the first level marks a cached pyramid
+        const std::string cacheFile = path::join(path::join(cacheDir, pyrDir), name + ".pmc");
+        if(!force && path::exists(binary ? cacheFile : levelFile(cacheDir, pyrDir, 1, name))){
+#pragma omp atomic
+            ++skipped;
+            continue;
+        }
+        try {
+            Image left = leftFrame(loadPNG(files[i]));
+            std::vector<Image> pyr = type == "gaussian" ? gaussianPyramid(left, levels) : laplacianPyramid(left, levels);
+            if(binary){
+                CacheWriter writer;
+                for(int l = 0; l < int(pyr.size()); ++l){
+                    writer.add("image", l + 1, pyr[l]);
+                }
+                path::makeDirectories(path::join(cacheDir, pyrDir));
+                // written aside so that an interrupted ingest does not look complete
+                if(!writer.save(cacheFile + ".tmp") || std::rename((cacheFile + ".tmp").c_str(), cacheFile.c_str()) != 0){
+                    throw std::runtime_error("cannot write " + cacheFile);
+                }
+                continue;
+            }
+            // the first level is written last, so that it marks complete pyramids
+            for(int l = pyr.size() - 1; l >= 0; --l){
+                std::string fname = levelFile(cacheDir, pyrDir, l + 1, name);
+                path::makeDirectories(fname.substr(0, fname.find_last_of('/') + 1));
+                if(!saveMat(fname, pyr[l])){
+                    throw std::runtime_error("cannot write " + fname);
+                }
+            }
+        } catch(const std::exception &e) {
+#pragma omp critical
+            {
+                std::cerr << "Could not process " << files[i] << ": " << e.what() << "\n";
+                ++failures;
+            }
+        }
+    }
+
+    std::cout << "Ingested " << files.size() - failures - skipped << " " << type << " pyramids into "
+              << path::join(cacheDir, pyrDir) << " (" << skipped << " cached)\n";
+    return failures > 0 ? 2 : 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * File:   stereo_synth.cpp
+ */
+
+#include "impl/stereo_synth.h"
+#include "impl/synth_plan.h"
+#include "image/frames.h"
+#include "io/directory.h"
+#include "io/gistpack.h"
+#include "io/png.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace pm;
+
+void usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [options] query.png image_dir output.png\n";
+    std::cerr << "  -p size     patch size (default: 7)\n";
+    std::cerr << "  -i iters    number of k-NNF iterations (default: 6)\n";
+    std::cerr << "  -l levels   number of pyramid reductions (default: from the image size)\n";
+    std::cerr << "  -t type     laplacian (default) or gaussian pyramid\n";
+    std::cerr << "  -n number   number of exemplars to use (default: from the memory budget)\n";
+    std::cerr << "  -m bytes    exemplar memory budget (default: 50e6)\n";
+    std::cerr << "  -b bytes    total memory budget, to choose k and the number of exemplars\n";
+    std::cerr << "  -K k        number of k-NNF entries (default: " << SYNTH_K << ")\n";
+    std::cerr << "  -I          start each level from the k-NNF of the previous one\n";
+    std::cerr << "  -P share    drop the exemplars with less than that share of the k-NNF entries between levels\n";
+    std::cerr << "  -R          skip the distance of the patches already rejected (hashed: a collision\n";
+    std::cerr << "              silently drops a candidate that could have improved the result)\n";
+    std::cerr << "  -g file     packed gists (default: image_dir/.cache/gist.pack if it exists)\n";
+    std::cerr << "  -r seed     random seed (default: time)\n";
+    std::cerr << "  -j threads  number of threads for the gists (default: all cores)\n";
+    std::cerr << "  -k sigma2   vote with all the k-NNF entries weighted by exp(-(d-dmin)/sigma2) (0 = automatic)\n";
+    std::cerr << "  -s          output the stereo pair (left on top of right)\n";
+}
+
+/**
+ * Exemplar frames decoded from their files when the synthesis needs them
+ */
+struct ExemplarFiles : public ExemplarSource {
+    explicit ExemplarFiles(const std::vector<std::string> &f) : files(f) {}
+    virtual size_t size() const {
+        return files.size();
+    }
+    virtual FrameSize frameSize(size_t n) const {
+        int rows, cols;
+        readPNGSize(files[n], &rows, &cols);
+        return FrameSize(cols, rows / 2); // left on top of right
+    }
+    virtual void load(size_t n, Image *left, Image *right) const {
+        splitFrames(loadPNG(files[n]), left, right);
+    }
+
+private:
+    std::vector<std::string> files;
+};
+
+/**
+ * Usage:
+ *
+ * stereo_synth [options] query.png image_dir output.png
+ *
+ * Native equivalent of toolbox/stereo_synth.m with the patch transfer:
+ * exemplar selection by gist, then k-NNF, top-1 and vote at each level.
+ */
+int main(int argc, char *argv[]) {
+    SynthParams params;
+    unsigned int randSeed = timeSeed();
+    int threads = 0;
+    bool pair = false;
+    std::string gistFile;
+    std::vector<std::string> args;
+    for(int i = 1; i < argc; ++i){
+        std::string arg(argv[i]);
+        bool hasValue = i + 1 < argc;
+        if(arg == "-p" && hasValue){
+            params.patchSize = std::atoi(argv[++i]);
+        } else if(arg == "-i" && hasValue){
+            params.iterations = std::atoi(argv[++i]);
+        } else if(arg == "-l" && hasValue){
+            params.levels = std::atoi(argv[++i]);
+        } else if(arg == "-t" && hasValue){
+            std::string type(argv[++i]);
+            if(type != "laplacian" && type != "gaussian"){
+                usage(argv[0]);
+                return 1;
+            }
+            params.laplacian = type == "laplacian";
+        } else if(arg == "-n" && hasValue){
+            params.targets = std::atoi(argv[++i]);
+        } else if(arg == "-m" && hasValue){
+            params.memory = std::atof(argv[++i]);
+        } else if(arg == "-b" && hasValue){
+            params.budget = std::atof(argv[++i]);
+        } else if(arg == "-K" && hasValue){
+            params.k = std::atoi(argv[++i]);
+        } else if(arg == "-I"){
+            params.incremental = true;
+        } else if(arg == "-P" && hasValue){
+            params.pruneThreshold = std::atof(argv[++i]);
+        } else if(arg == "-R"){
+            params.rejectMemo = true;
+        } else if(arg == "-g" && hasValue){
+            gistFile = argv[++i];
+        } else if(arg == "-r" && hasValue){
+            randSeed = std::strtoul(argv[++i], NULL, 10);
+        } else if(arg == "-j" && hasValue){
+            threads = std::atoi(argv[++i]);
+        } else if(arg == "-k" && hasValue){
+            params.knnVote = true;
+            params.knnSigma2 = std::atof(argv[++i]);
+        } else if(arg == "-s"){
+            pair = true;
+        } else if(arg == "-h" || arg == "--help"){
+            usage(argv[0]);
+            return 0;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if(args.size() != 3 || params.patchSize <= 0 || params.iterations < 0){
+        usage(argv[0]);
+        return 1;
+    }
+    const std::vector<int> &kValues = synthKValues();
+    if(std::find(kValues.begin(), kValues.end(), params.k) == kValues.end()){
+        std::cerr << "Unsupported k=" << params.k << " (compiled:";
+        for(int k : kValues){
+            std::cerr << " " << k;
+        }
+        std::cerr << ")\n";
+        return 1;
+    }
+#ifdef _OPENMP
+    if(threads > 0){
+        omp_set_num_threads(threads);
+    }
+#endif
+    seed(randSeed);
+    const std::string dir = args[1];
+    if(gistFile.empty() && path::exists(path::join(dir, ".cache/gist.pack"))){
+        gistFile = path::join(dir, ".cache/gist.pack");
+    }
+    clock_t start = clock();
+
+    try {
+        Image query = loadPNG(args[0]);
+        std::vector<std::string> files = findImages(dir);
+        if(files.empty()){
+            std::cerr << "No exemplar found in " << dir << "\n";
+            return 1;
+        }
+        const int N = files.size();
+
+        // 1 = exemplar gists (packed when available)
+        const GistExtractor extractor;
+        const int D = extractor.dimension(query.channels());
+        std::vector<float> gists(size_t(N) * D);
+        std::vector<bool> done(N, false);
+        GistPack pack;
+        if(!gistFile.empty()){
+            if(!pack.load(gistFile) || int(pack.dimension) != D){
+                std::cerr << "Ignoring incompatible gist pack " << gistFile << "\n";
+            } else {
+                std::map<std::string, int> index;
+                for(size_t i = 0; i < pack.size(); ++i){
+                    index[pack.names[i]] = i;
+                }
+                for(int n = 0; n < N; ++n){
+                    auto it = index.find(path::stem(files[n]));
+                    if(it != index.end()){
+                        std::copy(pack.row(it->second), pack.row(it->second) + D, &gists[size_t(n) * D]);
+                        done[n] = true;
+                    }
+                }
+            }
+        }
+        // only the missing gists need the decoded frames, the others their header
+        double numPixels = 0.0;
+        int failures = 0;
+#pragma omp parallel for schedule(dynamic) reduction(+:numPixels)
+        for(int n = 0; n < N; ++n){
+            try {
+                int rows, cols;
+                if(done[n]){
+                    readPNGSize(files[n], &rows, &cols);
+                } else {
+                    Image img = loadPNG(files[n]);
+                    rows = img.rows;
+                    cols = img.cols;
+                    extractor.compute(leftFrame(img), &gists[size_t(n) * D]);
+                }
+                numPixels += double(rows / 2) * cols;
+            } catch(const std::exception &e) {
+#pragma omp critical
+                {
+                    std::cerr << "Could not load " << files[n] << ": " << e.what() << "\n";
+                    ++failures;
+                }
+            }
+        }
+        if(failures > 0){
+            return 2;
+        }
+
+        // 2 = selection
+        std::vector<float> queryGist = extractor.compute(query);
+        SynthPlan plan = planSynthesis(params, N, query.rows, query.cols, query.channels(), numPixels / N, D);
+        if(!plan.fits){
+            std::cerr << "Warning: " << plan.footprint.total() << " bytes needed at least, over the budget of " << params.budget << "\n";
+        }
+        params.k = plan.k;
+        const int K = plan.targets;
+        std::vector<int> group = selectExemplars(queryGist, &gists[0], N, K);
+        std::vector<std::string> selected(K);
+        for(int k = 0; k < K; ++k){
+            selected[k] = files[group[k]];
+        }
+        ExemplarFiles exemplars(selected);
+        std::cout << "* Selected " << K << " of " << N << " exemplars, k=" << params.k
+                  << " (predicted " << plan.footprint.total() / 1e6 << " MB)\n";
+
+        // 3 = k-NNF, top-1 and vote over the pyramid
+        SynthFootprint usage;
+        usage.descriptors = gists.size() * sizeof(float);
+        Image right = synthesize(query, exemplars, params, &usage);
+        std::cout << "* Footprint " << usage.total() / 1e6 << " MB: nnf=" << usage.nnf / 1e6
+                  << ", exemplars=" << usage.exemplars / 1e6 << ", query=" << usage.query / 1e6
+                  << ", gists=" << usage.descriptors / 1e6 << "\n";
+        if(pair){
+            Image stereo(query.rows * 2, query.cols, query.type());
+            for(const Point2i &i : query){
+                stereo.at<Vec3f>(i.y, i.x) = query.at<Vec3f>(i);
+                stereo.at<Vec3f>(i.y + query.rows, i.x) = right.at<Vec3f>(i);
+            }
+            right = stereo;
+        }
+        savePNG(args[2], right);
+    } catch(const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "* Synthesis in " << double(clock() - start) / CLOCKS_PER_SEC << " cpu sec.\n";
+#if PM_PERF_COUNTERS
+    // stage counters (make tools PERF=1)
+    perfReport().write(std::cerr);
+#endif
+    return 0;
+}
@@ -11,7 +11,10 @@
 #include "../nnf/patch.h"
 #include "../math/mat.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
 
 namespace pm {
     
@@ -32,6 +35,23 @@ namespace pm {
         const Scalar &distance(const Point2i &i, int k = 0) const;
     };
     
+    namespace voting {
+
+        //! best finite distance of the K entries of a patch (0 if none)
+        template <typename Container>
+        inline float bestDistance(const Container &data, const Point2i &p, int K) {
+            float best = std::numeric_limits<float>::infinity();
+            for(int k = 0; k < K; ++k){
+                const float d = data.distance(p, k);
+                if(std::isfinite(d)){
+                    best = std::min(best, d);
+                }
+            }
+            return std::isfinite(best) ? best : 0.0f;
+        }
+
+    }
+
     template <int channels, typename VoteOperation>
     struct Vote {
         typedef typename VoteOperation::Next NextOperation;
@@ -14,56 +14,58 @@
 #include "../nnf/field.h"
 
 #include <algorithm>
-#include <map>
+#include <cassert>
+#include <cmath>
 #include <vector>
 
 namespace pm {
     
     namespace voting {
         
-        struct CDF {
-            
-            CDF(std::vector<float> &data, int sections = 100){
-                // sort data in ascending order
-                std::sort(data.begin(), data.end());
-                
-                // build cdf map
-                prctile.resize(sections + 1);
-                cdf[data.front()] = 0.0f;
-                cdf[data.back()] = 1.0f;
-                size_t N = data.size();
-                for(int i = 1; i < sections; ++i){
-                    size_t idx = std::round(float(i) / float(sections) * N);
-                    float item = data[idx];
-                    cdf[item] = float(i) / sections;
-                    prctile[i] = item; // store percentile for fast lookup
-                }
-            }
-            
-            inline float tail(float value) const {
-                auto it = cdf.upper_bound(value);
-                if(it == cdf.end()) return 1.0f;
-                return it->second;
-            }
-            
-            inline float head(float value) const {
-                return 1.0f - tail(value); 
-            }
-            
-            inline float percentile(float value) const {
-                size_t n = std::max(size_t(0), std::min(prctile.size() - 1, 
-                    size_t(std::floor(prctile.size() * value))
-                ));
-                return prctile[n];
+        //! index of the p-th percentile (p in [0;1]) among N sorted values
+        inline size_t percentileIndex(size_t N, float p) {
+            if(p <= 0.0f) return 0;
+            return std::min(N - 1, size_t(std::floor(p * N)));
+        }
+        
+        /**
+         * \brief Percentile of a set of values in linear time
+         *
+         * \param data
+         *          the values, which get partially reordered
+         * \param p
+         *          the percentile in [0;1]
+         */
+        inline float percentile(std::vector<float> &data, float p) {
+            assert(!data.empty() && "Percentile of nothing");
+            std::vector<float>::iterator nth = data.begin() + percentileIndex(data.size(), p);
+            std::nth_element(data.begin(), nth, data.end());
+            return *nth;
+        }
+        
+        /**
+         * \brief Multiple percentiles, each selection only partitioning
+         * the values above the previous one
+         *
+         * \param ps
+         *          the percentiles in ascending order
+         */
+        inline std::vector<float> percentiles(std::vector<float> &data, const std::vector<float> &ps) {
+            assert(!data.empty() && "Percentile of nothing");
+            std::vector<float> values(ps.size());
+            std::vector<float>::iterator first = data.begin();
+            for(size_t i = 0; i < ps.size(); ++i){
+                assert((i == 0 || ps[i - 1] <= ps[i]) && "Percentiles must be sorted");
+                std::vector<float>::iterator nth = data.begin() + percentileIndex(data.size(), ps[i]);
+                std::nth_element(first, nth, data.end());
+                values[i] = *nth;
+                first = nth;
             }
-            
-        private:
-            std::map<float, float> cdf;
-            std::vector<float> prctile;
-        };
+            return values;
+        }
         
         template <typename Patch >
-        inline auto disparity(const Point2i &i, const Patch &q){
+        inline typename Patch::point::vec disparity(const Point2i &i, const Patch &q){
             typedef typename Patch::point PixelLoc;
             typedef typename PixelLoc::vec Disparity;
             PixelLoc p(i);
@@ -79,11 +81,16 @@ namespace pm {
 	 *			the nearest neighbor field to vote with
 	 * \param params
 	 *			the voting parameters
+	 * \param sigma2
+	 *			if positive, all the K entries vote with weight exp(-(d - dmin) / sigma2)
+	 *			where dmin is the best distance of their patch
+	 * \param quiet
+	 *			whether to skip the report of the disparity percentiles
 	 * \return the voted picture
 	 */
 	template <int channels, typename Patch, typename Scalar, int K, int RowMajor = true>
 	Image disparity_vote(const PixelContainer<channels, Patch, Scalar, K> &data, const Filter &filter,
-        const Field2D<RowMajor> &field, float noisePercentile = 0.975f) {
+        const Field2D<RowMajor> &field, float noisePercentile = 0.975f, float sigma2 = 0.0f, bool quiet = false) {
         
         typedef typename Patch::point PixelLoc;
         // typedef typename PixelLoc::vec Disparity;
@@ -93,51 +100,73 @@ namespace pm {
         const Frame2D<Point2i, true> &frame = data.frame();
 		Image vote = Image::zeros(frame.size.rows, frame.size.cols, IM_32FC(2)); // u+v
         
-        // compute CDF of absolute disparity
-        std::vector<float> disp;
-        for(const Point2i &i : field){
-            for(int k = 0; k < K; ++k){
-                const Patch &p = data.patch(i, k);
-                Disparity d = voting::disparity(i, p);
-                disp.push_back(std::sqrt(d.dot(d)));
+        // absolute disparities (for the noise percentile)
+        std::vector<float> disp(size_t(field.width) * field.height * K);
+#pragma omp parallel for
+        for(int y = 0; y < field.height; ++y){
+            for(int x = 0; x < field.width; ++x){
+                const Point2i i(x, y);
+                float *d = &disp[(size_t(y) * field.width + x) * K];
+                for(int k = 0; k < K; ++k){
+                    Disparity v = voting::disparity(i, data.patch(i, k));
+                    d[k] = std::sqrt(v.dot(v));
+                }
             }
         }
-        voting::CDF cdf(disp, 200);
-        float maxDisparity = cdf.percentile(noisePercentile);
-        std::cout << "maxDisparity = " << maxDisparity << "\n";
-        std::cout << "percentiles:";
-        for(int i = 0; i < 100; i += 5){
-            std::cout << i << "%=" << cdf.percentile(i / 100.0f) << ", ";
+        float maxDisparity = voting::percentile(disp, noisePercentile);
+        if(!quiet){
+            std::cout << "maxDisparity = " << maxDisparity << "\n";
+            std::vector<float> ps;
+            for(int i = 0; i < 100; i += 5){
+                ps.push_back(i / 100.0f);
+            }
+            std::vector<float> values = voting::percentiles(disp, ps);
+            std::cout << "percentiles:";
+            for(size_t i = 0; i < ps.size(); ++i){
+                std::cout << (i * 5) << "%=" << values[i] << ", ";
+            }
+            std::cout << "\n";
         }
-        std::cout << "\n";
         
-        // TODO use distance for the weight
+        // the distances weight the entries if using all K of them
+        const int numEntries = sigma2 > 0.0f ? K : 1;
 
-		// for each pixel of the workspace
-        for(const Point2i &i : frame){
-            Disparity &disparity = vote.at<Disparity>(i);
-            Scalar weight = 0;
-            // use weighted average of overlapping patch pixels (kN^2 of them)
-            for(const Point2i &p : data.overlap(i)){
-                const Patch &patch = data.patch(p);
-                const Point2i b = i - p;
-                Disparity patchDisp = voting::disparity(p, patch);
-                float d = std::sqrt(patchDisp.dot(patchDisp));
+		// for each pixel of the workspace (parallel rows, only writing their pixels)
+#pragma omp parallel for schedule(dynamic)
+        for(int y = 0; y < vote.rows; ++y){
+            for(int x = 0; x < vote.cols; ++x){
+                const Point2i i(x, y);
+                Disparity &disparity = vote.at<Disparity>(i);
+                Scalar weight = 0;
+                // use weighted average of overlapping patch pixels (kN^2 of them)
+                for(const Point2i &p : data.overlap(i)){
+                    const Point2i b = i - p;
+                    const float dmin = sigma2 > 0.0f ? voting::bestDistance(data, p, K) : 0.0f;
+                    for(int k = 0; k < numEntries; ++k){
+                        const Patch &patch = data.patch(p, k);
+                        Disparity patchDisp = voting::disparity(p, patch);
+                        float d = std::sqrt(patchDisp.dot(patchDisp));
+                        if(d > maxDisparity){
+                            patchDisp[0] = std::max(-maxDisparity, std::min(maxDisparity, patchDisp[0]));
+                            patchDisp[1] = std::max(-maxDisparity, std::min(maxDisparity, patchDisp[1]));
+                        }
+                        float w = filter[b.y][b.x];
+                        if(sigma2 > 0.0f){
+                            w *= std::exp(-(data.distance(p, k) - dmin) / sigma2);
+                        }
+                        disparity += patchDisp * w;
+                        weight += w;
+                    }
+                }
+                if(weight > (sigma2 > 0.0f ? 0.0f : 1e-8)){
+                    disparity *= 1.0 / weight;
+                }
+                // clamp it if it is above what we tolerate
+                float d = std::sqrt(disparity.dot(disparity));
                 if(d > maxDisparity){
-                    patchDisp[0] = std::max(-maxDisparity, std::min(maxDisparity, patchDisp[0]));
-                    patchDisp[1] = std::max(-maxDisparity, std::min(maxDisparity, patchDisp[1]));
+                    disparity[0] = std::max(-maxDisparity, std::min(maxDisparity, disparity[0]));
+                    disparity[1] = std::max(-maxDisparity, std::min(maxDisparity, disparity[1]));
                 }
-                disparity += patchDisp * filter[b.y][b.x];
-                weight += filter[b.y][b.x];
-            }
-            if(weight > 1e-8){
-                disparity *= 1.0 / weight;
-            }
-            // clamp it if it is above what we tolerate
-            float d = std::sqrt(disparity.dot(disparity));
-            if(d > maxDisparity){
-                disparity[0] = std::max(-maxDisparity, std::min(maxDisparity, disparity[0]));
-                disparity[1] = std::max(-maxDisparity, std::min(maxDisparity, disparity[1]));
             }
         }
 		return vote;
@@ -0,0 +1,59 @@
+/*
+ * File:   median.h
+ */
+
+#ifndef VOTING_MEDIAN_H
+#define	VOTING_MEDIAN_H
+
+#include <algorithm>
+#include <utility>
+
+namespace pm {
+
+    namespace voting {
+
+        /**
+         * \brief Weighted quickselect
+         *
+         * \param items the (value, weight) pairs, reordered in place
+         * \param n the number of items (> 0)
+         * \param middle the weight to reach
+         * \return the first value (in ascending order) whose cumulated weight reaches middle
+         */
+        template <typename Scalar, typename Weight>
+        Scalar weightedSelect(std::pair<Scalar, Weight> *items, int n, Weight middle) {
+            int lo = 0, hi = n;
+            Weight before = Weight(0); // weight of the values below [lo;hi)
+            while(hi - lo > 1) {
+                const Scalar pivot = items[lo + (hi - lo) / 2].first;
+                // three-way partition: [lo;lt) < pivot, [lt;gt) == pivot, [gt;hi) > pivot
+                int lt = lo, i = lo, gt = hi;
+                Weight wLess = Weight(0), wEqual = Weight(0);
+                while(i < gt) {
+                    if(items[i].first < pivot) {
+                        wLess += items[i].second;
+                        std::swap(items[lt++], items[i++]);
+                    } else if(pivot < items[i].first) {
+                        std::swap(items[i], items[--gt]);
+                    } else {
+                        wEqual += items[i++].second;
+                    }
+                }
+                if(before + wLess >= middle && lt > lo) {
+                    hi = lt;
+                } else if(before + wLess + wEqual >= middle || gt == hi) {
+                    return pivot;
+                } else {
+                    before += wLess + wEqual;
+                    lo = gt;
+                }
+            }
+            return items[std::min(lo, n - 1)].first;
+        }
+
+    }
+
+}
+
+#endif	/* VOTING_MEDIAN_H */
+
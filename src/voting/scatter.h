@@ -0,0 +1,128 @@
+/*
+ * File:   scatter.h
+ */
+
+#ifndef VOTING_SCATTER_H
+#define	VOTING_SCATTER_H
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace pm {
+
+    namespace voting {
+
+        /**
+         * \brief Parallel scatter of items writing to bands of rows
+         *
+         * Item n only writes to the rows [tops[n]; tops[n] + footprint).
+         * The items are bucketed by bands of footprint rows, and the even
+         * bands then the odd ones are processed in parallel: the rows written
+         * by two bands of a phase never overlap, so that the scatter needs
+         * neither atomics nor per-thread buffers.
+         * The items of a band are processed in increasing order.
+         *
+         * \param tops the top row of each item (in [0; rows))
+         * \param footprint the maximum number of rows written by an item
+         * \param rows the number of rows
+         * \param scatter the function called with each item index
+         */
+        template <typename Scatter>
+        void bandScatter(const std::vector<int> &tops, int footprint, int rows, const Scatter &scatter) {
+            const int numBands = rows / footprint + 1;
+            std::vector< std::vector<int> > bands(numBands);
+            for (int n = 0, N = tops.size(); n < N; ++n) {
+                bands[tops[n] / footprint].push_back(n);
+            }
+            for (int phase = 0; phase < 2; ++phase) {
+#if _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+                for (int b = phase; b < numBands; b += 2) {
+                    const std::vector<int> &band = bands[b];
+                    for (int j = 0, J = band.size(); j < J; ++j) {
+                        scatter(band[j]);
+                    }
+                }
+            }
+        }
+
+
+        /**
+         * \brief Parallel scatter of the patches of a field, through halo tiles
+         *
+         * Patch (y, x) of the h x w field adds its weighted values to the
+         * pixels [y; y + P) x [x; x + P) of a rows x cols image.
+         * Each tile of tileSize x tileSize patches accumulates into a
+         * thread-private halo buffer, which is then merged into the image.
+         * The tiles (ty, tx) are processed in four phases by parity of
+         * (ty, tx): as tileSize >= P - 1, the halos of a phase never overlap,
+         * so that the merge needs no lock.
+         *
+         * \param contribute called as w = contribute(y, x, py, px, value)
+         *        to get the value of pixel (py, px) of patch (y, x) and its weight
+         * \param merge called as merge(y, x, value, weight) to add the
+         *        accumulated value and weight of a tile to pixel (y, x)
+         */
+        template <typename Value, typename Contribution, typename Merge>
+        void tiledScatter(int h, int w, int P, int tileSize, int rows, int cols,
+                const Contribution &contribute, const Merge &merge) {
+            assert(tileSize >= P - 1 && "Halos of the same phase would overlap!");
+            const int haloSize = tileSize + P - 1;
+            const int tilesY = (h + tileSize - 1) / tileSize;
+            const int tilesX = (w + tileSize - 1) / tileSize;
+            for (int phase = 0; phase < 4; ++phase) {
+                const int ty0 = phase / 2, tx0 = phase % 2;
+                const int tilesPY = (tilesY - ty0 + 1) / 2, tilesPX = (tilesX - tx0 + 1) / 2;
+#if _OPENMP
+#pragma omp parallel
+#endif
+                {
+                    // thread-private halo buffers
+                    std::vector<Value> haloValues(haloSize * haloSize);
+                    std::vector<float> haloWeights(haloSize * haloSize);
+#if _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+                    for (int t = 0; t < tilesPY * tilesPX; ++t) {
+                        const int y0 = (ty0 + 2 * (t / tilesPX)) * tileSize;
+                        const int x0 = (tx0 + 2 * (t % tilesPX)) * tileSize;
+                        const int y1 = std::min(y0 + tileSize, h), x1 = std::min(x0 + tileSize, w);
+                        std::fill(haloValues.begin(), haloValues.end(), Value());
+                        std::fill(haloWeights.begin(), haloWeights.end(), 0.0f);
+                        // for each patch of the tile
+                        for (int y = y0; y < y1; ++y) {
+                            for (int x = x0; x < x1; ++x) {
+                                // for each pixel in the patch
+                                for (int py = 0; py < P; ++py) {
+                                    const int hy = haloSize * (y - y0 + py);
+                                    for (int px = 0; px < P; ++px) {
+                                        const int hi = hy + x - x0 + px;
+                                        Value value;
+                                        const float weight = contribute(y, x, py, px, value);
+                                        haloValues[hi] += value * weight;
+                                        haloWeights[hi] += weight;
+                                    }
+                                }
+                            }
+                        }
+                        // merge the halo (no other tile of this phase touches it)
+                        const int hy1 = std::min(y1 + P - 1, rows), hx1 = std::min(x1 + P - 1, cols);
+                        for (int y = y0; y < hy1; ++y) {
+                            const int hy = haloSize * (y - y0);
+                            for (int x = x0; x < hx1; ++x) {
+                                merge(y, x, haloValues[hy + x - x0], haloWeights[hy + x - x0]);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    }
+
+}
+
+#endif	/* VOTING_SCATTER_H */
+
@@ -12,7 +12,69 @@
 #include "../math/filter.h"
 #include "../math/mat.h"
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace pm {
+
+    namespace voting {
+
+        /**
+         * Summed area table of the filter weights, for the normalization
+         * of the votes by the filter rectangles covering each pixel
+         */
+        struct FilterIntegral {
+            explicit FilterIntegral(const Filter &f) : n(f.width), sum((n + 1) * (n + 1), 0.0) {
+                for(int y = 0; y < n; ++y){
+                    for(int x = 0; x < n; ++x){
+                        sum[(y + 1) * (n + 1) + x + 1] = f[y][x]
+                                + sum[y * (n + 1) + x + 1] + sum[(y + 1) * (n + 1) + x] - sum[y * (n + 1) + x];
+                    }
+                }
+            }
+
+            //! sum of the weights over [y0;y1) x [x0;x1)
+            inline double rect(int y0, int y1, int x0, int x1) const {
+                return sum[y1 * (n + 1) + x1] - sum[y0 * (n + 1) + x1] - sum[y1 * (n + 1) + x0] + sum[y0 * (n + 1) + x0];
+            }
+
+            int n;
+            std::vector<double> sum;
+        };
+
+        /**
+         * \brief Default scale of the k-NN vote weights exp(-(d - dmin) / sigma2)
+         *
+         * \return the mean of the best patch distances of the field
+         */
+        template <typename Container>
+        inline float knnScale(const Container &data, int nnfHeight, int nnfWidth, int K) {
+            double sum = 0.0;
+            int count = 0;
+            for(int y = 0; y < nnfHeight; ++y){
+                for(int x = 0; x < nnfWidth; ++x){
+                    float best = data.distance(Point2i(x, y), 0);
+                    for(int k = 1; k < K; ++k){
+                        best = std::min(best, data.distance(Point2i(x, y), k));
+                    }
+                    if(std::isfinite(best)){
+                        sum += best;
+                        ++count;
+                    }
+                }
+            }
+            return count > 0 && sum > 0.0 ? sum / count : 1.0f;
+        }
+
+        inline bool isFlat(const Filter &f) {
+            for(size_t i = 1; i < f.weight.size(); ++i){
+                if(f.weight[i] != f.weight[0]) return false;
+            }
+            return true;
+        }
+
+    }
     
     /**
 	 * \brief Vote by using a simple filter over overlapping patches
@@ -31,21 +93,173 @@ namespace pm {
         const Frame2D<Point2i, true> &frame = data.frame();
 		Image vote = Image::zeros(frame.size.rows, frame.size.cols, IM_32FC(channels));
 
-		// for each pixel of the workspace
-        for(const Point2i &i : frame){
-            Pixel &votedPixel = vote.at<Pixel>(i);
-            Scalar weight = 0;
-            // use weighted average of overlapping patch pixels
-			SubFrame2D<Point2i, true> overlap = data.overlap(i);
-            for(const Point2i &p : overlap){
-                const Patch &patch = data.patch(p);
-                const Point2i b = i - p;
-                const Pixel &pixel = data.pixel(patch.transform(b));
-                votedPixel += pixel * filter[b.y][b.x];
-                weight += filter[b.y][b.x];
-            }
-            if(weight > 1e-8){
-                votedPixel *= 1.0 / weight;
+		// for each pixel of the workspace (parallel rows, only writing their pixels)
+#pragma omp parallel for schedule(dynamic)
+        for(int y = 0; y < vote.rows; ++y){
+            for(int x = 0; x < vote.cols; ++x){
+                const Point2i i(x, y);
+                Pixel &votedPixel = vote.at<Pixel>(i);
+                Scalar weight = 0;
+                // use weighted average of overlapping patch pixels
+                SubFrame2D<Point2i, true> overlap = data.overlap(i);
+                for(const Point2i &p : overlap){
+                    const Patch &patch = data.patch(p);
+                    const Point2i b = i - p;
+                    const Pixel &pixel = data.pixel(patch.transform(b));
+                    votedPixel += pixel * filter[b.y][b.x];
+                    weight += filter[b.y][b.x];
+                }
+                if(weight > 1e-8){
+                    votedPixel *= 1.0 / weight;
+                }
+            }
+        }
+		return vote;
+	}
+
+    /**
+     * \brief Same vote as weighted_average, but scattering the patches
+     *
+     * The patches are visited in row order and their rows accumulated
+     * into the contiguous rows of the vote, without any overlap query.
+     * Bands of patch rows are processed in parallel, the even bands
+     * first, then the odd ones, so that no two threads write the same
+     * pixel. The weight normalization only depends on the pixel location
+     * and is read from the summed area table of the filter.
+     * Flat filters skip the weighting of the patch pixels.
+     */
+	template <int channels, typename Patch, typename Scalar>
+	Image scatter_average(const PixelContainer<channels, Patch, Scalar> &data, const Filter &filter) {
+		typedef Vec<Scalar, channels> Pixel;
+
+        // create workspace
+        const Frame2D<Point2i, true> &frame = data.frame();
+		Image vote = Image::zeros(frame.size.rows, frame.size.cols, IM_32FC(channels));
+        const int P = Patch::width();
+        const int nnfHeight = vote.rows - P + 1, nnfWidth = vote.cols - P + 1;
+        if(nnfHeight <= 0 || nnfWidth <= 0){
+            return vote;
+        }
+        assert(filter.width >= P && "Filter smaller than the patches");
+        const bool flat = voting::isFlat(filter);
+
+        // accumulate the patches by bands of rows (band k writes k*H to (k+1)*H+P-1)
+        const int H = std::max(1, P - 1);
+        const int numBands = (nnfHeight + H - 1) / H;
+        for(int phase = 0; phase < 2; ++phase){
+#pragma omp parallel for schedule(dynamic)
+            for(int k = phase; k < numBands; k += 2){
+                const int yEnd = std::min(nnfHeight, (k + 1) * H);
+                for(int py = k * H; py < yEnd; ++py){
+                    for(int px = 0; px < nnfWidth; ++px){
+                        const Patch &patch = data.patch(Point2i(px, py));
+                        for(int by = 0; by < P; ++by){
+                            Pixel *row = vote.ptr<Pixel>(py + by, px);
+                            const float *w = filter[by];
+                            if(flat){
+                                for(int bx = 0; bx < P; ++bx){
+                                    row[bx] += data.pixel(patch.transform(Point2i(bx, by)));
+                                }
+                            } else {
+                                for(int bx = 0; bx < P; ++bx){
+                                    row[bx] += data.pixel(patch.transform(Point2i(bx, by))) * w[bx];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // normalize by the filter part covering each pixel
+        const voting::FilterIntegral integral(filter);
+        const double scale = flat ? filter.weight[0] : 1.0;
+#pragma omp parallel for
+        for(int y = 0; y < vote.rows; ++y){
+            const int by0 = std::max(0, y - nnfHeight + 1), by1 = std::min(P - 1, y) + 1;
+            for(int x = 0; x < vote.cols; ++x){
+                const int bx0 = std::max(0, x - nnfWidth + 1), bx1 = std::min(P - 1, x) + 1;
+                double weight = integral.rect(by0, by1, bx0, bx1);
+                if(weight > 1e-8){
+                    vote.at<Pixel>(y, x) *= scale / weight;
+                }
+            }
+        }
+		return vote;
+	}
+
+    /**
+     * \brief Vote with all the K entries of each patch
+     *
+     * Each entry contributes with the filter weight times exp(-(d - dmin) / sigma2),
+     * where d is its patch distance and dmin the best one of the patch, so
+     * that no top-1 extraction is needed. The best entry always has weight 1,
+     * which keeps outlier patches from underflowing to a zero weight.
+     * The patches are scattered by bands of rows as in scatter_average.
+     *
+     * \param sigma2
+     *          the scale of the distances (<= 0 for the mean best distance)
+     */
+	template <int channels, typename Patch, typename Scalar, int K>
+	Image knn_average(const PixelContainer<channels, Patch, Scalar, K> &data, const Filter &filter, float sigma2 = 0.0f) {
+		typedef Vec<Scalar, channels> Pixel;
+
+        // create workspace
+        const Frame2D<Point2i, true> &frame = data.frame();
+		Image vote = Image::zeros(frame.size.rows, frame.size.cols, IM_32FC(channels));
+        const int P = Patch::width();
+        const int nnfHeight = vote.rows - P + 1, nnfWidth = vote.cols - P + 1;
+        if(nnfHeight <= 0 || nnfWidth <= 0){
+            return vote;
+        }
+        assert(filter.width >= P && "Filter smaller than the patches");
+        if(sigma2 <= 0.0f){
+            sigma2 = voting::knnScale(data, nnfHeight, nnfWidth, K);
+        }
+        const float invSigma2 = 1.0f / sigma2;
+        std::vector<double> weights(size_t(vote.rows) * vote.cols, 0.0);
+
+        // accumulate the patches by bands of rows (band k writes k*H to (k+1)*H+P-1)
+        const int H = std::max(1, P - 1);
+        const int numBands = (nnfHeight + H - 1) / H;
+        for(int phase = 0; phase < 2; ++phase){
+#pragma omp parallel for schedule(dynamic)
+            for(int b = phase; b < numBands; b += 2){
+                const int yEnd = std::min(nnfHeight, (b + 1) * H);
+                for(int py = b * H; py < yEnd; ++py){
+                    for(int px = 0; px < nnfWidth; ++px){
+                        const Point2i p(px, py);
+                        const float dmin = voting::bestDistance(data, p, K);
+                        for(int k = 0; k < K; ++k){
+                            const float d = data.distance(p, k);
+                            if(!std::isfinite(d)){
+                                continue; // uninitialized entry
+                            }
+                            const Patch &patch = data.patch(p, k);
+                            const float w = std::exp(-(d - dmin) * invSigma2);
+                            for(int by = 0; by < P; ++by){
+                                Pixel *row = vote.ptr<Pixel>(py + by, px);
+                                double *rowWeight = &weights[size_t(py + by) * vote.cols + px];
+                                const float *f = filter[by];
+                                for(int bx = 0; bx < P; ++bx){
+                                    row[bx] += data.pixel(patch.transform(Point2i(bx, by))) * (w * f[bx]);
+                                    rowWeight[bx] += w * f[bx];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // normalize
+#pragma omp parallel for
+        for(int y = 0; y < vote.rows; ++y){
+            for(int x = 0; x < vote.cols; ++x){
+                double weight = weights[size_t(y) * vote.cols + x];
+                if(weight > 0.0){
+                    vote.at<Pixel>(y, x) *= 1.0 / weight;
+                }
             }
         }
 		return vote;
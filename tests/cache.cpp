@@ -0,0 +1,214 @@
+// we do not test with matlab here
+#define USE_MATLAB 0
+
+#include "image/pyramid.h"
+#include "impl/ix_k_nnf.h"
+#include "io/cache.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <iostream>
+
+using namespace pm;
+
+typedef NearestNeighborField<Patch2tix, float, 3> NNF;
+
+/**
+ * Test the binary cache container
+ */
+int main() {
+
+    // 1: a pyramid and a custom type plane
+    Image img(37, 29, IM_32FC3);
+    for(const Point2i &i : img){
+        Vec3f &v = img.at<Vec3f>(i);
+        v = Vec3f(i.x, i.y, i.x * i.y);
+    }
+    std::vector<Image> pyr = gaussianPyramid(img, 2);
+    Image mask(5, 7, IM_8UC1);
+    for(const Point2i &i : mask){
+        mask.at<unsigned char>(i) = i.x + i.y;
+    }
+    CacheWriter writer;
+    for(int l = 0; l < int(pyr.size()); ++l){
+        writer.add("image", l + 1, pyr[l]);
+    }
+    writer.add("mask", 1, mask);
+    bool saved = writer.save("bin/test_cache.pmc");
+    assert(saved && "Could not save cache file");
+
+    // 2: mapped planes
+    {
+        CacheFile cache("bin/test_cache.pmc");
+        assert(cache.isOpen() && cache.contents().size() == 4 && "Invalid cache contents");
+        assert(cache.levels("image") == 3 && cache.levels("mask") == 1 && "Invalid cache levels");
+        assert(!cache.has("image", 4) && cache.get("uv", 1).empty() && "Unexpected cache plane");
+        for(int l = 0; l < 3; ++l){
+            Image m = cache.get("image", l + 1);
+            assert(m.rows == pyr[l].rows && m.cols == pyr[l].cols && m.type() == pyr[l].type() && "Invalid plane header");
+            assert(reinterpret_cast<uintptr_t>(m.ptr()) % CacheAlignment == 0 && "Unaligned plane");
+            for(const Point2i &i : m){
+                assert(m.at<Vec3f>(i) == pyr[l].at<Vec3f>(i) && "Invalid plane data");
+            }
+        }
+        Image m = cache.get("mask", 1);
+        assert(m.type() == IM_8UC1 && m.at<unsigned char>(4, 6) == 10 && "Invalid mask plane");
+    }
+
+    // 3: planes outlive the file object and writes stay private
+    Image finest;
+    {
+        CacheFile cache("bin/test_cache.pmc");
+        finest = cache.get("image", 3);
+    }
+    assert(finest.at<Vec3f>(2, 3) == Vec3f(3, 2, 6) && "Mapping released too early");
+    finest.at<Vec3f>(2, 3) = Vec3f(0, 0, 0);
+    assert(CacheFile("bin/test_cache.pmc").get("image", 3).at<Vec3f>(2, 3) == Vec3f(3, 2, 6) && "Mapping is not private");
+
+    // 4: image sets
+    std::vector<std::string> files(2, "bin/test_cache.pmc");
+    ImageSet set;
+    bool ok = loadImageSet(files, "image", 2, &set);
+    assert(ok && set.size() == 2 && set[1].rows == pyr[1].rows && "Invalid mapped image set");
+    assert(!loadImageSet(files, "image", 5, &set) && "Loaded missing planes");
+    std::string file;
+    int level;
+    parseCacheSpec("dir/a.pmc:12", &file, &level);
+    assert(file == "dir/a.pmc" && level == 12 && "Invalid cache reference");
+    parseCacheSpec("c:/a.pmc", &file, &level);
+    assert(file == "c:/a.pmc" && level == 1 && "Invalid cache reference");
+
+    // 5: nnf storage round-trip
+    Patch2tix::width(7);
+    ImageSet targets(1);
+    targets[0] = img;
+    DistanceFunc d = DistanceFactory<Patch2tix, float, ImageSet>::get(dist::SSD, 3);
+    NNF nnf(img, targets, d);
+    for(const Point2i &i : nnf){
+        nnf.init(i);
+    }
+    Mat compact;
+    bool compacted = nnf.compact(compact);
+    assert(compacted && "Could not compact the nnf");
+    NNF farIndex(img, targets, d);
+    for(const Point2i &i : farIndex){
+        farIndex.init(i);
+    }
+    farIndex.store(Point2i(0, 0), Patch2tix(Point2i(0, 0), 70000), 0.0f);
+    assert(!farIndex.compact(compact) && "Compacted an exemplar index out of range");
+    CacheWriter nnfWriter;
+    nnfWriter.add("nnf", 1, nnf.raw());
+    saved = nnfWriter.save("bin/test_cache_nnf.pmc");
+    assert(saved && "Could not save nnf cache");
+    NNF nnf2(img, targets, d);
+    nnf2.load(CacheFile("bin/test_cache_nnf.pmc").get("nnf", 1));
+    for(const Point2i &i : nnf){
+        for(int k = 0; k < 3; ++k){
+            assert(nnf.patch(i, k) == nnf2.patch(i, k) && nnf.distance(i, k) == nnf2.distance(i, k) && "Invalid mapped nnf");
+        }
+    }
+
+    // 6: an nnf added to an exemplar cache keeps its image planes
+    {
+        CacheWriter exemplar;
+        exemplar.add("image", 1, img);
+        saved = exemplar.save("bin/test_cache_update.pmc");
+        assert(saved && "Could not save exemplar cache");
+        // mapped while being updated (as by mxCachedImage in the same call)
+        CacheFile mapped("bin/test_cache_update.pmc");
+        Image before = mapped.get("image", 1);
+        bool updated = updateCache("bin/test_cache_update.pmc", "nnf", 1, nnf.raw());
+        assert(updated && "Could not add the nnf plane");
+        updated = updateCache("bin/test_cache_update.pmc", "nnf", 1, nnf.raw());
+        assert(updated && "Could not replace the nnf plane");
+        CacheFile cache("bin/test_cache_update.pmc");
+        assert(cache.contents().size() == 2 && "The nnf plane was not replaced");
+        Image image = cache.get("image", 1);
+        assert(image.rows == img.rows && image.cols == img.cols && "The image plane was lost");
+        for(const Point2i &i : img){
+            assert(image.at<Vec3f>(i) == img.at<Vec3f>(i) && before.at<Vec3f>(i) == img.at<Vec3f>(i) && "Invalid image plane");
+        }
+        NNF nnf3(img, targets, d);
+        nnf3.load(cache.get("nnf", 1));
+        for(const Point2i &i : nnf){
+            assert(nnf.patch(i, 0) == nnf3.patch(i, 0) && "Invalid updated nnf");
+        }
+        // other files are not overwritten
+        std::ofstream("bin/test_cache_other.txt") << "not a cache";
+        assert(!updateCache("bin/test_cache_other.txt", "nnf", 1, nnf.raw()) && "Overwrote a non-cache file");
+    }
+
+    // 7: column-major views are stored as row-major planes
+    {
+        const int h = img.rows, w = img.cols;
+        DataPtr planes(new byte[h * w * 3 * sizeof(float)]);
+        float *data = reinterpret_cast<float *>(planes.get());
+        for(const Point2i &i : img){
+            for(int c = 0; c < 3; ++c){
+                data[i.y + i.x * h + c * h * w] = img.at<Vec3f>(i)[c];
+            }
+        }
+        CacheWriter viewWriter;
+        viewWriter.add("image", 1, Mat::columnMajor(h, w, IM_32FC3, planes));
+        saved = viewWriter.save("bin/test_cache_view.pmc");
+        assert(saved && "Could not save a column-major view");
+        Image m = CacheFile("bin/test_cache_view.pmc").get("image", 1);
+        assert(m.layout() == IM_ROW_MAJOR && m.rows == h && m.cols == w && "Invalid view plane header");
+        for(const Point2i &i : img){
+            assert(m.at<Vec3f>(i) == img.at<Vec3f>(i) && "Invalid view plane data");
+        }
+    }
+
+    // 8: invalid plane headers are rejected
+    {
+        CacheHeader header = { { 'P', 'M', 'C', 'F' }, CacheVersion, 1, CacheAlignment };
+        CachePlane valid;
+        std::memset(&valid, 0, sizeof(valid));
+        std::strcpy(valid.name, "mask");
+        valid.level = 1;
+        valid.rows = 4;
+        valid.cols = 4;
+        valid.type = IM_32FC1;
+        valid.elemSize = sizeof(float);
+        valid.offset = CacheAlignment;
+        auto opens = [&](const CachePlane &p) {
+            std::ofstream out("bin/test_cache_bad.pmc", std::ios::binary);
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(&p), sizeof(p));
+            out.write(std::string(CacheAlignment - sizeof(header) - sizeof(p) + 4 * 4 * sizeof(float), '\0').data(),
+                      CacheAlignment - sizeof(header) - sizeof(p) + 4 * 4 * sizeof(float));
+            out.close();
+            return CacheFile("bin/test_cache_bad.pmc").isOpen();
+        };
+        assert(opens(valid) && "Rejected a valid plane");
+        CachePlane p = valid;
+        p.rows = -4;
+        assert(!opens(p) && "Accepted negative rows");
+        p = valid;
+        p.cols = -1;
+        assert(!opens(p) && "Accepted negative columns");
+        p = valid;
+        p.rows = 1 << 30;
+        p.cols = 1 << 30;
+        p.type = IM_MAKETYPE(IM_USRTYPE, 1);
+        p.elemSize = 1u << 31;
+        assert(!opens(p) && "Accepted an overflowing plane size");
+        p = valid;
+        p.elemSize = 1;
+        assert(!opens(p) && "Accepted an element size that does not match the type");
+        p = valid;
+        p.type = -1;
+        assert(!opens(p) && "Accepted an invalid type");
+        p = valid;
+        std::memset(p.name, 'x', sizeof(p.name));
+        assert(!opens(p) && "Accepted an unterminated plane name");
+        p = valid;
+        p.offset = std::numeric_limits<uint64_t>::max() - 63;
+        assert(!opens(p) && "Accepted an overflowing offset");
+    }
+
+    return 0;
+}
@@ -6,14 +6,17 @@
 #endif
 
 #include "impl/k_disp.h"
+#include "impl/k_disp_container.h"
 #include "nnf/algorithm.h"
 #include "nnf/propagation.h"
 #include "nnf/horizontalsearch.h"
 #include "nnf/horizontalrandsearch.h"
 #include "nnf/randpropagation.h"
 #include "scanline.h"
+#include "voting/disparity_vote.h"
 
 // png++
+#include <cstring>
 #include "../libs/pngpp/png.hpp"
 
 #include <cassert>
@@ -21,6 +24,10 @@
 #include <iostream>
 #include <limits>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace pm;
 
 typedef NearestNeighborField<Patch2tf, float, KNNF_K> NNF;
@@ -99,6 +106,52 @@ int main() {
     // check patches
     checkNNF(nnf);
     
+    // linear-time percentiles
+    std::vector<float> values;
+    for(int i = 0; i < 1000; ++i){
+        values.push_back(float((i * 7919) % 1000));
+    }
+    std::vector<float> ps = { 0.0f, 0.25f, 0.5f, 0.975f, 1.0f };
+    std::vector<float> prc = voting::percentiles(values, ps);
+    assert(prc[0] == 0.0f && prc[1] == 250.0f && prc[2] == 500.0f && prc[3] == 975.0f && prc[4] == 999.0f && "Invalid percentiles");
+    assert(voting::percentile(values, 0.1f) == 100.0f && "Invalid percentile");
+    
+    // quiet disparity votes (top and distance-weighted k entries)
+    PixelContainer<2, Patch2tf, float, KNNF_K> data(&nnf);
+    Filter flat(7);
+    for(float sigma2 : { 0.0f, 1.0f }){
+#ifdef _OPENMP
+        omp_set_num_threads(4);
+#endif
+        Image uv = disparity_vote(data, flat, nnf, 0.975f, sigma2, true);
+        assert(uv.rows == source.rows && uv.cols == source.cols && "Invalid vote size");
+        for(const Point2i &i : uv){
+            const Vec2f &v = uv.at<Vec2f>(i);
+            assert(std::isfinite(v[0]) && std::isfinite(v[1]) && "Invalid disparity vote");
+        }
+        // parallel rows only write their own pixels: same vote as a single thread
+#ifdef _OPENMP
+        omp_set_num_threads(1);
+#endif
+        Image serial = disparity_vote(data, flat, nnf, 0.975f, sigma2, true);
+        for(const Point2i &i : uv){
+            const Vec2f &v = uv.at<Vec2f>(i), &s = serial.at<Vec2f>(i);
+            assert(v[0] == s[0] && v[1] == s[1] && "Parallel disparity vote differs from the serial one");
+        }
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(omp_get_num_procs());
+#endif
+    
+    // outlier patch: the weights are relative to its best entry
+    Image uv = disparity_vote(data, flat, nnf, 0.975f, 1.0f, true);
+    for(int k = 0; k < KNNF_K; ++k){
+        nnf.data.at(0, 0)[k].distance += 1e3f;
+    }
+    Image outlier = disparity_vote(data, flat, nnf, 0.975f, 1.0f, true);
+    const Vec2f &v0 = uv.at<Vec2f>(0, 0), &v1 = outlier.at<Vec2f>(0, 0);
+    assert(std::abs(v1[0] - v0[0]) < 1e-3f && std::abs(v1[1] - v0[1]) < 1e-3f && "Outlier patch vote underflowed");
+    
     return 0;
 }
 
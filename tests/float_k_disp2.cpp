@@ -1,5 +1,7 @@
 // we do not test with matlab here
 #define USE_MATLAB 0
+// with the per-step statistics
+#define PM_STEP_STATS 1
 
 #ifndef KNNF_K
 #define KNNF_K 7
@@ -15,6 +17,7 @@
 #include "scanline.h"
 
 // png++
+#include <cstring>
 #include "../libs/pngpp/png.hpp"
 
 #include <cassert>
@@ -111,6 +114,20 @@ int main() {
         }
         std::cout << "\n";
     }
+
+    // statistics rows: counts, then time, evaluations, early-outs and duplicates
+    const size_t steps = seq.counts().size();
+    assert(convData.size() == steps * (1 + StepStats::NumFields) && "Missing statistics rows");
+    for(size_t j = 0; j < steps; ++j){
+        size_t updates = 0, evals = 0;
+        for(size_t iter = 0; iter < convData[j].size(); ++iter){
+            assert(convData[j][iter] <= convData[steps * (1 + StepStats::DistEvals) + j][iter] && "More updates than distance evaluations");
+            updates += convData[j][iter];
+            evals += convData[steps * (1 + StepStats::DistEvals) + j][iter];
+        }
+        assert(updates == seq.counts()[j] && "Diary does not sum to the counts");
+        assert(evals == seq.statistics()[j][StepStats::DistEvals] && "Diary does not sum to the evaluations");
+    }
     
     // check patches
     checkNNF(nnf);
@@ -0,0 +1,129 @@
+#include "gist/gist.h"
+#include "io/gistpack.h"
+#include "io/png.h"
+#include "math/fft.h"
+
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+using namespace pm;
+
+float maxError(const std::vector<Complex> &a, const std::vector<Complex> &b) {
+    float err = 0.0f;
+    for(size_t i = 0; i < a.size(); ++i){
+        err = std::max(err, std::abs(a[i] - b[i]));
+    }
+    return err;
+}
+
+/**
+ * Test the FFT and the native gist descriptor
+ */
+int main() {
+
+    // 1: mixed-radix FFT against a naive DFT
+    int sizes[] = { 1, 2, 6, 8, 12, 19, 42, 266 };
+    for(int n : sizes){
+        std::vector<Complex> x(n), X(n), ref(n), back(n);
+        for(int i = 0; i < n; ++i){
+            x[i] = Complex(std::sin(0.3f * i) + 0.1f * i, std::cos(1.7f * i));
+        }
+        for(int k = 0; k < n; ++k){
+            std::complex<double> sum = 0;
+            for(int i = 0; i < n; ++i){
+                double phase = -2.0 * M_PI * double(i) * k / n;
+                sum += std::complex<double>(x[i]) * std::complex<double>(std::cos(phase), std::sin(phase));
+            }
+            ref[k] = Complex(sum);
+        }
+        FFTPlan(n).transform(&x[0], &X[0]);
+        assert(maxError(X, ref) < 1e-3f * n && "FFT differs from DFT");
+        FFTPlan(n, true).transform(&X[0], &back[0]);
+        for(Complex &c : back) c /= float(n);
+        assert(maxError(back, x) < 1e-4f * n && "Inverse FFT does not invert");
+    }
+
+    // 2: 2D transform round-trip
+    {
+        const int rows = 10, cols = 12;
+        std::vector<Complex> a(rows * cols), b;
+        for(int i = 0; i < rows * cols; ++i) a[i] = Complex(i % 7, i % 3);
+        b = a;
+        FFT2D(rows, cols).transform(&b[0]);
+        FFT2D(rows, cols, true).transform(&b[0]);
+        assert(maxError(a, b) < 1e-3f && "2D FFT round-trip failed");
+    }
+
+    // 3: gist descriptor
+    GistParams params;
+    params.imageSize = 64;
+    GistExtractor extractor(params);
+    assert(params.features() == 512 && "Invalid default number of features");
+
+    Image img = loadPNG("tests/data/a.png");
+    std::vector<float> g = extractor.compute(img);
+    assert(int(g.size()) == extractor.dimension(3) && "Invalid gist dimension");
+    for(float v : g){
+        assert(std::isfinite(v) && v >= 0.0f && "Invalid gist value");
+    }
+    // deterministic
+    std::vector<float> g2 = extractor.compute(img);
+    assert(g == g2 && "Gist is not deterministic");
+
+    // invariant to intensity scaling (per-channel normalization)
+    Image darker(img.rows, img.cols, IM_32FC3);
+    for(const Point2i &i : img){
+        darker.at<Vec3f>(i) = img.at<Vec3f>(i) * 0.5f;
+    }
+    std::vector<float> g3 = extractor.compute(darker);
+    for(size_t i = 0; i < g.size(); ++i){
+        assert(std::abs(g[i] - g3[i]) <= 1e-3f * (1.0f + g[i]) && "Gist not invariant to scaling");
+    }
+
+    // different images have different gists
+    std::vector<float> h = extractor.compute(loadPNG("tests/data/A.png"));
+    float diff = 0.0f;
+    for(size_t i = 0; i < g.size(); ++i) diff += std::abs(g[i] - h[i]);
+    assert(diff > 0.0f && "Different images with the same gist");
+
+    // golden gist of the 56 x 56 center of a.png (no resampling)
+    // the reference was computed by a float64 NumPy transcription of
+    // LMgist.m (prefilt, createGabor, gistGabor) with the imgist.m parameters
+    {
+        GistParams golden;
+        golden.imageSize = 56;
+        std::vector<float> g56 = GistExtractor(golden).compute(img);
+        std::ifstream refFile("tests/data/a_gist56.txt");
+        std::vector<float> ref;
+        float v;
+        while(refFile >> v) ref.push_back(v);
+        assert(ref.size() == g56.size() && "Invalid golden gist file");
+        for(size_t i = 0; i < ref.size(); ++i){
+            assert(std::abs(g56[i] - ref[i]) <= 1e-5f + 1e-3f * ref[i] && "Gist differs from LMgist");
+        }
+    }
+
+    // 4: pack round-trip
+    GistPack pack(2, g.size(), 3);
+    pack.names[0] = "a";
+    pack.names[1] = "A";
+    std::copy(g.begin(), g.end(), pack.row(0));
+    std::copy(h.begin(), h.end(), pack.row(1));
+    bool saved = pack.save("bin/test_gist.pack");
+    assert(saved && "Could not save gist pack");
+    GistPack loaded;
+    bool ok = loaded.load("bin/test_gist.pack");
+    assert(ok && "Could not load gist pack");
+    assert(loaded.size() == 2 && loaded.names[1] == "A" && loaded.dimension == g.size() && "Invalid pack header");
+    assert(loaded.data == pack.data && "Invalid pack data");
+
+    // rows of failed images are dropped
+    std::vector<bool> valid(2, true);
+    valid[0] = false;
+    pack.keep(valid);
+    assert(pack.size() == 1 && pack.names[0] == "A" && pack.data == h && "Invalid rows were not dropped");
+
+    return 0;
+}
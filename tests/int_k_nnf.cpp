@@ -1,15 +1,20 @@
 // we do not test with matlab here
 #define USE_MATLAB 0
+// count the distance evaluations
+#define PM_STEP_STATS 1
 
 #include "impl/int_k_nnf.h"
 #include "nnf/algorithm.h"
 #include "nnf/propagation.h"
+#include "nnf/region.h"
 #include "nnf/uniformsearch.h"
 #include "scanline.h"
 
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <vector>
 
 using namespace pm;
 
@@ -62,7 +67,105 @@ int main() {
         // scanline with the sequence of algorithm
         scanline(nnf, 3, seq);
     
-        // TODO 
+        // masked update after a local change of the source
+        std::vector<Patch2ti> patches;
+        std::vector<float> dists;
+        for(const auto &i : nnf){
+            for(int k = 0; k < 7; ++k){
+                patches.push_back(nnf.patch(i, k));
+                dists.push_back(nnf.distance(i, k));
+            }
+        }
+        std::vector<Bounds2i> rects(1, Bounds2i(Vec2i(40, 30), Vec2i(49, 34)));
+        Mask dirty = rectMask(source.height, source.width, rects);
+        for(const auto &i : source){
+            if(dirty.at<float>(i) != 0.0f){
+                source.at<Vec3f>(i)[2] = 50;
+            }
+        }
+        const int halo = 4;
+        Mask region = patchRegion(dirty, nnf.height, nnf.width, 7, halo);
+        Mask reinit = patchRegion(dirty, nnf.height, nnf.width, 7, 0);
+        assert(maskCount(reinit) == 16 * 11 && "Invalid number of dirty patches");
+        assert(maskCount(region) == 24 * 19 && "Invalid size of the update region");
+        size_t n = scanlineRegion(nnf, dirty, halo, 3, seq);
+        assert(n == maskCount(region) && "Invalid number of processed patches");
+        size_t idx = 0;
+        for(const auto &i : nnf){
+            for(int k = 0; k < 7; ++k, ++idx){
+                const Patch2ti &p = nnf.patch(i, k);
+                if(region.at<float>(i) == 0.0f){
+                    assert(p.x == patches[idx].x && p.y == patches[idx].y && nnf.distance(i, k) == dists[idx]
+                        && "Entry outside of the region was modified");
+                } else {
+                    assert(std::abs(nnf.distance(i, k) - nnf.dist(i, p)) < 1e-3f
+                        && "Entry distance does not match the new source");
+                }
+            }
+        }
+
+        // compact copy (8 bytes per entry)
+        Mat compact;
+        bool compacted = nnf.compact(compact);
+        assert(compacted && compact.elemSize() == 8 * 7 && "Invalid compact entry size");
+        NNF copy(source, target, d);
+        copy.loadCompact(compact);
+        for(const auto &i : nnf){
+            for(int k = 0; k < 7; ++k){
+                assert(copy.patch(i, k) == nnf.patch(i, k) && "Compact patch does not match");
+                float d0 = nnf.distance(i, k), d1 = copy.distance(i, k);
+                assert(std::abs(d1 - d0) <= 3.5e-4f * d0 && "Compact distance out of tolerance");
+            }
+        }
+        // offsets beyond 16 bits are reported
+        copy.store(Point2i(0, 0), Patch2ti(Point2i(40000, 0)), 0.0f);
+        assert(!copy.compact(compact) && "Compacted an offset out of range");
+        assert(quantizeDistance(std::numeric_limits<float>::infinity()) == CompactNoDistance
+            && std::isinf(expandDistance(CompactNoDistance)) && "Infinite distance is not preserved");
+        assert(quantizeDistance(0.0f) == 0 && expandDistance(0) == 0.0f && "Zero distance is not preserved");
+        // relative error and order on normalized distances
+        uint16_t lastQ = 0;
+        for(float d0 = 1e-4f; d0 <= 1.0f; d0 *= 1.001f){
+            uint16_t q = quantizeDistance(d0);
+            assert(q >= lastQ && "Compact distance order is not preserved");
+            assert(std::abs(expandDistance(q) - d0) <= 3.5e-4f * d0 && "Compact distance relative error too large");
+            lastQ = q;
+        }
+        assert(quantizeDistance(1e-4f) != quantizeDistance(1.001e-4f) && "Distinct small distances are tied");
+        assert(quantizeDistance(1e-9f) == 1 && "Tiny distance below the floor");
+        assert(quantizeDistance(std::numeric_limits<float>::max()) == CompactNoDistance && "Unset distance is not preserved");
+
+        // memo of the rejected patches: same search, fewer distances
+        NNF plain(source, target, d), memoized(source, target, d);
+        RejectMemo memo(memoized.width, memoized.height);
+        memoized.memo = &memo;
+        size_t evals[2];
+        NNF *fields[2] = { &plain, &memoized };
+        for(int f = 0; f < 2; ++f){
+            seed(1);
+            for(const auto &i : *fields[f]){
+                fields[f]->init(i);
+            }
+            auto fseq = Algorithm() << UniformSearch<Patch2ti, float, 7>(fields[f]) << Propagation<Patch2ti, float, 7>(fields[f]);
+            NoOp<Point2i> noFilter;
+            trialCounters().reset();
+            scanline(*fields[f], 6, fseq, noFilter);
+            evals[f] = trialCounters()[StepStats::DistEvals];
+        }
+        assert(evals[1] * 100 <= evals[0] * 96 && "The memo skipped less than 4% of the distances");
+        for(const auto &i : plain){
+            for(int k = 0; k < 7; ++k){
+                assert(plain.patch(i, k) == memoized.patch(i, k) && plain.distance(i, k) == memoized.distance(i, k)
+                    && "The memo changed the search result");
+            }
+        }
+        Point2i p0(0, 0);
+        uint32_t h = RejectMemo::hash(Patch2ti(Point2i(3, 4)));
+        memo.reject(p0, h);
+        assert(memo.rejected(p0, h) && !memo.rejected(Point2i(1, 0), h) && "Rejected patch is not memoized");
+        memo.clear();
+        assert(!memo.rejected(p0, h) && "The memo was not cleared");
+        std::cout << "memo: " << evals[0] << " -> " << evals[1] << " distance evaluations\n";
     // }
     
     return 0;
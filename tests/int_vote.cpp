@@ -11,6 +11,10 @@
 #include <cmath>
 #include <iostream>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace pm;
 
 typedef NearestNeighborField<Patch2ti, float, 1> NNF;
@@ -88,6 +92,35 @@ int main() {
         }
     }
     
+    // scatter voting gives the same result (flat and gaussian filters)
+    PixelContainer<3, Patch2ti, float> data(&nnf);
+    Filter gaussian = gaussianFilter(7, 2.0f);
+    for(const Filter *f : { &filter, &gaussian }){
+#ifdef _OPENMP
+        omp_set_num_threads(4);
+#endif
+        Image ref = weighted_average(data, *f);
+        Image scatter = scatter_average(data, *f);
+        for(const Point2i &i : ref){
+            for(int c = 0; c < 3; ++c){
+                assert(std::abs(ref.at<Vec3f>(i)[c] - scatter.at<Vec3f>(i)[c]) < 1e-4f && "Different scatter vote");
+            }
+        }
+        // parallel rows only write their own pixels: same vote as a single thread
+#ifdef _OPENMP
+        omp_set_num_threads(1);
+#endif
+        Image serial = weighted_average(data, *f);
+        for(const Point2i &i : ref){
+            for(int c = 0; c < 3; ++c){
+                assert(ref.at<Vec3f>(i)[c] == serial.at<Vec3f>(i)[c] && "Parallel vote differs from the serial one");
+            }
+        }
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(omp_get_num_procs());
+#endif
+    
     return 0;
 }
 
@@ -0,0 +1,113 @@
+// we do not test with matlab here
+#define USE_MATLAB 0
+
+#include "impl/ix_k_nnf.h"
+#include "impl/ix_nnf_container.h"
+#include "voting/weighted_average.h"
+
+#include <cassert>
+#include <iostream>
+
+using namespace pm;
+
+typedef NearestNeighborField<Patch2tix, float, 3> NNF;
+
+/**
+ * Test the column-major views (as created from Matlab arrays)
+ */
+int main() {
+
+    // 1: row-major image and its column-major planes
+    const int h = 37, w = 29;
+    Image img(h, w, IM_32FC3);
+    DataPtr planes(new byte[h * w * 3 * sizeof(float)]);
+    float *data = reinterpret_cast<float *>(planes.get());
+    for(const Point2i &i : img){
+        Vec3f v(i.x, i.y, i.x * i.y + 0.5f);
+        img.at<Vec3f>(i) = v;
+        for(int c = 0; c < 3; ++c){
+            data[i.y + i.x * h + c * h * w] = v[c];
+        }
+    }
+    Image view = Mat::columnMajor(h, w, IM_32FC3, planes);
+    assert(view.layout() == IM_COL_MAJOR && img.layout() == IM_ROW_MAJOR && "Invalid layouts");
+    assert(view.elemSize() == img.elemSize() && view.channels() == 3 && "Invalid view type");
+    for(const Point2i &i : img){
+        assert(view.pixel<Vec3f>(i) == img.pixel<Vec3f>(i) && "Invalid view pixel");
+        assert(view.pixel<float>(i) == img.at<float>(i) && "Invalid view channel");
+    }
+
+    // 2: image set access (discrete and interpolated)
+    ImageSet rows(1), cols(1);
+    rows[0] = img;
+    cols[0] = view;
+    const ImageSet &crows = rows, &ccols = cols;
+    assert(ccols.at<Vec3f>(IndexedPoint<int>(5, 7, 0)) == crows.at<Vec3f>(IndexedPoint<int>(5, 7, 0)) && "Invalid set access");
+    IndexedPoint<float> p(3.25f, 4.5f, 0);
+    assert(ccols.at<Vec3f>(p) == crows.at<Vec3f>(p) && "Invalid interpolated access");
+
+    // 3: same distances over both layouts
+    Patch2tix::width(7);
+    DistanceFunc d = DistanceFactory<Patch2tix, float, ImageSet>::get(dist::SSD, 3);
+    NNF nnf(img, rows, d), nnf2(img, cols, d);
+    seed(1);
+    for(const Point2i &i : nnf){
+        nnf.init(i);
+    }
+    seed(1);
+    for(const Point2i &i : nnf2){
+        nnf2.init(i);
+    }
+    for(const Point2i &i : nnf){
+        for(int k = 0; k < 3; ++k){
+            assert(nnf.patch(i, k) == nnf2.patch(i, k) && "Different initialization");
+            assert(nnf.distance(i, k) == nnf2.distance(i, k) && "Different distances");
+        }
+    }
+
+    // 4: same vote over both layouts
+    typedef NearestNeighborField<Patch2tix, float, 1> NNF1;
+    NNF1 top(img, rows, d), top2(img, cols, d);
+    for(const Point2i &i : nnf){
+        top.store(i, nnf.patch(i, 0), nnf.distance(i, 0));
+        top2.store(i, nnf2.patch(i, 0), nnf2.distance(i, 0));
+    }
+    Filter filter(7);
+    PixelContainer<3, Patch2tix, float, 1> votes(&top), votes2(&top2);
+    Image v = weighted_average(votes, filter), v2 = weighted_average(votes2, filter);
+    for(const Point2i &i : v){
+        assert(v.at<Vec3f>(i) == v2.at<Vec3f>(i) && "Different votes");
+    }
+
+    // 5: aligned storage, zeroed both from the heap and from mappings
+    assert(isAligned<byte>(img.ptr(), MAT_ALIGNMENT) && "Misaligned matrix");
+    Image small = Image::zeros(5, 3, IM_32FC3);
+    Image large = Image::zeros(1200, 1000, IM_32FC3); // above MAT_MAP_THRESHOLD
+    assert(isAligned<byte>(small.ptr(), MAT_ALIGNMENT) && isAligned<byte>(large.ptr(), MAT_ALIGNMENT) && "Misaligned zeros");
+    for(const Point2i &i : small){
+        assert(small.at<Vec3f>(i) == Vec3f::zeros() && "Non-zero small matrix");
+    }
+    for(const Point2i &i : large){
+        assert(large.at<Vec3f>(i) == Vec3f::zeros() && "Non-zero large matrix");
+    }
+
+    // 6: column-major views of other depths (byte and double planes)
+    DataPtr bytes(new byte[h * w * 2]);
+    DataPtr doubles(new byte[h * w * 2 * sizeof(double)]);
+    double *ddata = reinterpret_cast<double *>(doubles.get());
+    for(const Point2i &i : img){
+        for(int c = 0; c < 2; ++c){
+            bytes.get()[i.y + i.x * h + c * h * w] = byte((i.x + 3 * i.y + c) % 256);
+            ddata[i.y + i.x * h + c * h * w] = i.x * 0.5 + i.y * 0.25 + c;
+        }
+    }
+    Image bview = Mat::columnMajor(h, w, IM_8UC(2), bytes), dview = Mat::columnMajor(h, w, IM_64FC(2), doubles);
+    for(const Point2i &i : img){
+        Vec<unsigned char, 2> b = bview.pixel<Vec<unsigned char, 2> >(i);
+        Vec<double, 2> v = dview.pixel<Vec<double, 2> >(i);
+        assert(b[0] == (i.x + 3 * i.y) % 256 && b[1] == (i.x + 3 * i.y + 1) % 256 && "Invalid byte view pixel");
+        assert(v[0] == i.x * 0.5 + i.y * 0.25 && v[1] == v[0] + 1 && "Invalid double view pixel");
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "voting/median.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace pm;
+
+typedef std::pair<float, float> Item;
+
+//! first value (in ascending order) whose cumulated weight reaches middle
+float sortedMedian(std::vector<Item> items, float middle) {
+    std::sort(items.begin(), items.end());
+    float cumul = 0.0f;
+    for(const Item &it : items){
+        cumul += it.second;
+        if(cumul >= middle){
+            return it.first;
+        }
+    }
+    return items.back().first;
+}
+
+/**
+ * Test that the weighted quickselect matches a sort-based weighted median
+ */
+int main(){
+
+    std::srand(7);
+
+    for(int it = 0; it < 20000; ++it){
+        int n = 1 + std::rand() % 100;
+        // few distinct values for duplicates (half of the sets)
+        int range = it % 2 ? 1 + std::rand() % 5 : 1000;
+        std::vector<Item> items(n);
+        float total = 0.0f;
+        for(int i = 0; i < n; ++i){
+            // dyadic weights (including zeros) so that all the sums are exact
+            items[i] = Item(float(std::rand() % range), (std::rand() % 9) * 0.25f);
+            total += items[i].second;
+        }
+        const float middle = total * 0.5f;
+        const float expected = sortedMedian(items, middle);
+
+        std::vector<Item> work(items);
+        const float value = voting::weightedSelect(&work[0], n, middle);
+        if(value != expected){
+            std::cerr << "Set #" << it << " of " << n << " items: " << value << " != " << expected << "\n";
+        }
+        assert(value == expected && "Weighted select differs from the sorted median!");
+
+        // the items are only reordered
+        std::sort(work.begin(), work.end());
+        std::sort(items.begin(), items.end());
+        assert(work == items && "Weighted select changed the items!");
+    }
+
+    // uniform weights: the lower median
+    std::vector<Item> items;
+    for(int i = 0; i < 6; ++i){
+        items.push_back(Item(float(5 - i), 1.0f));
+    }
+    assert(voting::weightedSelect(&items[0], 6, 3.0f) == 2.0f && "Wrong lower median!");
+
+    // a heavy value wins
+    items.clear();
+    items.push_back(Item(1.0f, 1.0f));
+    items.push_back(Item(9.0f, 10.0f));
+    items.push_back(Item(2.0f, 1.0f));
+    assert(voting::weightedSelect(&items[0], 3, 6.0f) == 9.0f && "Wrong weighted median!");
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "image/pyramid.h"
+#include "sampling/uniform.h"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace pm;
+
+// reference filtering of toolbox/pyr_kernel.m with zero padding (imfilter 'conv')
+float filtered(const Image &img, int y, int x, int c) {
+    float sum = 0.0f;
+    for(int j = 0; j < 5; ++j){
+        for(int i = 0; i < 5; ++i){
+            int sy = y + j - 2, sx = x + i - 2;
+            if(sy >= 0 && sx >= 0 && sy < img.rows && sx < img.cols){
+                sum += pyramid::kernel[j] * pyramid::kernel[i] * img.ptr<float>(sy, sx)[c];
+            }
+        }
+    }
+    return sum;
+}
+
+Image randomImage(int rows, int cols, int channels) {
+    Image img(rows, cols, IM_32FC(channels));
+    for(const Point2i &i : img){
+        for(int c = 0; c < channels; ++c){
+            img.ptr<float>(i.y, i.x)[c] = unif01();
+        }
+    }
+    return img;
+}
+
+float maxDiff(const Image &a, const Image &b) {
+    assert(a.rows == b.rows && a.cols == b.cols && a.type() == b.type());
+    float d = 0.0f;
+    for(const Point2i &i : a){
+        for(int c = 0; c < a.channels(); ++c){
+            d = std::max(d, std::abs(a.ptr<float>(i.y, i.x)[c] - b.ptr<float>(i.y, i.x)[c]));
+        }
+    }
+    return d;
+}
+
+/**
+ * Test the native pyramid against the toolbox definitions
+ */
+int main() {
+
+    // 1: levels as pyr_levels.m
+    assert(pyramidLevels(256, 512) == 4 && "Invalid number of levels");
+    assert(pyramidLevels(255, 512) == 3 && "Invalid number of levels");
+    assert(pyramidLevels(10, 10) == 0 && "Invalid number of levels");
+
+    for(int channels = 1; channels <= 3; channels += 2){
+        for(int rows = 17; rows <= 18; ++rows){
+            const int cols = 23;
+            Image img = randomImage(rows, cols, channels);
+
+            // 2: reduce = blur + subsample
+            Image small = pyrReduce(img);
+            assert(small.rows == (rows + 1) / 2 && small.cols == (cols + 1) / 2 && "Invalid reduced size");
+            for(const Point2i &i : small){
+                for(int c = 0; c < channels; ++c){
+                    float ref = filtered(img, 2 * i.y, 2 * i.x, c);
+                    assert(std::abs(small.ptr<float>(i.y, i.x)[c] - ref) < 1e-5f && "Invalid reduce");
+                }
+            }
+
+            // 3: expand = zero interleave + blur * 4
+            Image up = Image::zeros(2 * small.rows, 2 * small.cols, small.type());
+            for(const Point2i &i : small){
+                for(int c = 0; c < channels; ++c){
+                    up.ptr<float>(2 * i.y, 2 * i.x)[c] = small.ptr<float>(i.y, i.x)[c];
+                }
+            }
+            Image big = pyrExpand(small, rows, cols);
+            for(const Point2i &i : big){
+                for(int c = 0; c < channels; ++c){
+                    float ref = 4.0f * filtered(up, i.y, i.x, c);
+                    assert(std::abs(big.ptr<float>(i.y, i.x)[c] - ref) < 1e-5f && "Invalid expand");
+                }
+            }
+
+            // 4: laplacian pyramid and its collapse
+            std::vector<Image> gauss = gaussianPyramid(img, 2);
+            assert(gauss.size() == 3 && gauss.back().ptr() == img.ptr() && "Invalid gaussian pyramid");
+            std::vector<Image> lapl = laplacianPyramid(img, 2);
+            assert(lapl.size() == 3 && maxDiff(lapl[0], gauss[0]) == 0.0f && "Invalid coarse level");
+            assert(maxDiff(pyramidTop(img, 2), gauss[0]) == 0.0f && "Invalid pyramid top");
+            Image band = pyrExpand(gauss[1], img.rows, img.cols);
+            for(const Point2i &i : band){
+                for(int c = 0; c < channels; ++c){
+                    float &b = band.ptr<float>(i.y, i.x)[c];
+                    b = img.ptr<float>(i.y, i.x)[c] - b;
+                }
+            }
+            assert(maxDiff(lapl[2], band) < 1e-5f && "Invalid laplacian band");
+            assert(lapl[2].ptr() != img.ptr() && "Laplacian overwrote the image");
+            Image back = pyrCollapse(lapl);
+            assert(maxDiff(back, img) < 1e-5f && "Collapse does not invert the pyramid");
+            assert(maxDiff(lapl[1], gauss[1]) < 1e-5f && "Collapse is not in place");
+        }
+    }
+
+    return 0;
+}
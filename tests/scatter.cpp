@@ -0,0 +1,192 @@
+#include "voting/scatter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace pm;
+
+//! rectangle of pixels an item adds its value to
+struct Item {
+    int top, height, left, width;
+    float value;
+};
+
+const int Rows = 48, Cols = 32;
+
+//! serial accumulation of the items (the reference)
+std::vector<float> serialScatter(const std::vector<Item> &items) {
+    std::vector<float> out(Rows * Cols, 0.0f);
+    for(const Item &it : items){
+        for(int y = it.top; y < it.top + it.height; ++y){
+            for(int x = it.left; x < it.left + it.width; ++x){
+                out[Cols * y + x] += it.value;
+            }
+        }
+    }
+    return out;
+}
+
+// tiled scatter: field of patches, tiles and the tile each thread is processing
+const int FieldH = 70, FieldW = 45, P = 5, TileSize = 8;
+const int TilesX = (FieldW + TileSize - 1) / TileSize;
+thread_local int currentTile = -1;
+thread_local int currentRun = -1;
+
+inline int tileOf(int y, int x) {
+    return (y / TileSize) * TilesX + x / TileSize;
+}
+inline int phaseOf(int tile) {
+    return (tile / TilesX % 2) * 2 + tile % TilesX % 2;
+}
+
+//! integer value and dyadic weight of pixel (py, px) of patch (y, x)
+inline float tileValue(int y, int x, int py, int px) {
+    return float((7 * y + 3 * x + py * P + px) % 13);
+}
+inline float tileWeight(int py, int px) {
+    return 0.5f * (1 + (py + px) % 3);
+}
+
+/**
+ * Test that the parallel band and tiled scatters give the serial accumulation
+ */
+int main(){
+
+    std::srand(11);
+
+    for(int footprint = 1; footprint <= 9; footprint += 4){
+        // random items of at most footprint rows
+        std::vector<Item> items(3000);
+        std::vector<int> tops(items.size());
+        for(size_t n = 0; n < items.size(); ++n){
+            Item &it = items[n];
+            it.height = 1 + std::rand() % footprint;
+            it.top = std::rand() % (Rows - it.height + 1);
+            it.width = 1 + std::rand() % 7;
+            it.left = std::rand() % (Cols - it.width + 1);
+            it.value = float(1 + std::rand() % 16); // exact sums in any order
+            tops[n] = it.top;
+        }
+        const std::vector<float> serial = serialScatter(items);
+
+        for(int threads = 4; threads >= 1; threads -= 3){
+#ifdef _OPENMP
+            omp_set_num_threads(threads);
+#endif
+            std::vector<float> out(Rows * Cols, 0.0f);
+            // rows being written by the running items
+            std::vector< std::atomic<int> > writers(Rows);
+            for(int y = 0; y < Rows; ++y){
+                writers[y] = 0;
+            }
+            std::atomic<bool> overlap(false);
+            voting::bandScatter(tops, footprint, Rows, [&](int n) {
+                const Item &it = items[n];
+                for(int y = it.top; y < it.top + it.height; ++y){
+                    if(writers[y]++ > 0){
+                        overlap = true;
+                    }
+                }
+                std::this_thread::yield(); // let the other bands run meanwhile
+                for(int y = it.top; y < it.top + it.height; ++y){
+                    for(int x = it.left; x < it.left + it.width; ++x){
+                        out[Cols * y + x] += it.value;
+                    }
+                    --writers[y];
+                }
+            });
+            assert(!overlap && "Concurrent items wrote to the same rows!");
+            for(int i = 0; i < Rows * Cols; ++i){
+                if(out[i] != serial[i]){
+                    std::cerr << "Footprint " << footprint << ", " << threads << " threads, ";
+                    std::cerr << "pixel " << (i / Cols) << "/" << (i % Cols) << ": " << out[i] << " != " << serial[i] << "\n";
+                }
+                assert(out[i] == serial[i] && "Band scatter differs from the serial accumulation!");
+            }
+        }
+    }
+
+    // tiled scatter
+    const int rows = FieldH + P - 1, cols = FieldW + P - 1;
+    std::vector<float> serialValues(rows * cols, 0.0f), serialWeights(rows * cols, 0.0f);
+    for(int y = 0; y < FieldH; ++y){
+        for(int x = 0; x < FieldW; ++x){
+            for(int py = 0; py < P; ++py){
+                for(int px = 0; px < P; ++px){
+                    const float w = tileWeight(py, px);
+                    serialValues[cols * (y + py) + x + px] += tileValue(y, x, py, px) * w;
+                    serialWeights[cols * (y + py) + x + px] += w;
+                }
+            }
+        }
+    }
+    for(int threads = 4, run = 0; threads >= 1; threads -= 3, ++run){
+#ifdef _OPENMP
+        omp_set_num_threads(threads);
+#endif
+        std::vector<float> values(rows * cols, 0.0f), weights(rows * cols, 0.0f);
+        std::mutex lock;
+        std::vector<int> started; // tiles in the order they start
+        std::vector< std::vector<int> > mergers(rows * cols); // tiles merging into each pixel
+        voting::tiledScatter<float>(FieldH, FieldW, P, TileSize, rows, cols,
+            [&](int y, int x, int py, int px, float &value) {
+                const int tile = tileOf(y, x);
+                if(currentRun != run || currentTile != tile){
+                    currentRun = run;
+                    currentTile = tile;
+                    std::lock_guard<std::mutex> guard(lock);
+                    started.push_back(tile);
+                }
+                value = tileValue(y, x, py, px);
+                return tileWeight(py, px);
+            },
+            [&](int y, int x, const float &value, float weight) {
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    mergers[cols * y + x].push_back(currentTile);
+                }
+                values[cols * y + x] += value;
+                weights[cols * y + x] += weight;
+            });
+
+        // each tile once, one phase after the other
+        const int numTiles = ((FieldH + TileSize - 1) / TileSize) * TilesX;
+        assert(int(started.size()) == numTiles && "Tiles are missing or processed twice!");
+        std::vector<bool> finished(4, false);
+        for(size_t t = 1; t < started.size(); ++t){
+            if(phaseOf(started[t - 1]) != phaseOf(started[t])){
+                finished[phaseOf(started[t - 1])] = true;
+            }
+            assert(!finished[phaseOf(started[t])] && "A tile started after the end of its phase!");
+        }
+        for(int i = 0; i < rows * cols; ++i){
+            // the halos of a phase are disjoint
+            std::vector<int> phases;
+            for(int tile : mergers[i]){
+                phases.push_back(phaseOf(tile));
+            }
+            std::sort(phases.begin(), phases.end());
+            assert(std::adjacent_find(phases.begin(), phases.end()) == phases.end()
+                    && "Two tiles of the same phase merged into the same pixel!");
+            // same accumulation as the serial scatter
+            if(values[i] != serialValues[i] || weights[i] != serialWeights[i]){
+                std::cerr << threads << " threads, pixel " << (i / cols) << "/" << (i % cols) << ": ";
+                std::cerr << values[i] << "/" << weights[i] << " != " << serialValues[i] << "/" << serialWeights[i] << "\n";
+            }
+            assert(values[i] == serialValues[i] && weights[i] == serialWeights[i]
+                    && "Tiled scatter differs from the serial accumulation!");
+        }
+    }
+
+    return 0;
+}
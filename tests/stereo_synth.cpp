@@ -0,0 +1,218 @@
+#include "impl/stereo_synth.h"
+#include "impl/synth_plan.h"
+#include "io/png.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using namespace pm;
+
+float meanError(const Image &a, const Image &b) {
+    assert(a.rows == b.rows && a.cols == b.cols && "Different image sizes");
+    double err = 0.0;
+    for(const Point2i &i : a){
+        Vec3f d = a.at<Vec3f>(i) - b.at<Vec3f>(i);
+        err += std::abs(d[0]) + std::abs(d[1]) + std::abs(d[2]);
+    }
+    return err / (3.0 * a.rows * a.cols);
+}
+
+/**
+ * Exemplars loaded on demand (as from files), counting the loads
+ */
+struct DiskExemplars : public ExemplarImages {
+    DiskExemplars(const std::vector<Image> &l, const std::vector<Image> &r) : ExemplarImages(l, r), loads(0) {}
+    virtual void load(size_t n, Image *left, Image *right) const {
+        ExemplarImages::load(n, left, right);
+        ++loads;
+    }
+    virtual size_t memory() const {
+        return 0;
+    }
+    mutable int loads;
+};
+
+/**
+ * Test the native synthesis pipeline
+ */
+int main() {
+    seed(1);
+
+    // 1: selection
+    std::vector<float> query(2, 0.0f);
+    float gists[] = { 3, 0,  1, 1,  0, 0.5f,  -2, 0 };
+    std::vector<int> group = selectExemplars(query, gists, 4, 2);
+    assert(group.size() == 2 && group[0] == 2 && group[1] == 1 && "Invalid exemplar selection");
+    SynthParams params;
+    assert(targetNumber(params, 100, 50e6 / 80) == 10 && "Invalid target number");
+    assert(targetNumber(params, 3, 1e6) == 3 && "Too many targets");
+    params.targets = 2;
+    assert(targetNumber(params, 100, 1.0) == 2 && "Fixed target number ignored");
+
+    // 2: an exemplar whose right frame is its left one is transferred as is
+    Image a = loadPNG("tests/data/a.png");
+    Image b = loadPNG("tests/data/b.png");
+    int rows = 0, cols = 0;
+    readPNGSize("tests/data/a.png", &rows, &cols);
+    assert(rows == a.rows && cols == a.cols && "Invalid png header size");
+    std::vector<Image> lefts(2), rights(2);
+    lefts[0] = rights[0] = a;
+    lefts[1] = rights[1] = b;
+    params.levels = 1;
+    Image right = synthesize(a, lefts, rights, params);
+    assert(right.rows == a.rows && right.cols == a.cols && right.type() == a.type() && "Invalid output");
+    float err = meanError(right, a);
+    std::cout << "Identity transfer error: " << err << "\n";
+    assert(err < 0.02f && "Identity transfer failed");
+
+    // 3: same with all the k entries voting
+    params.knnVote = true;
+    right = synthesize(a, lefts, rights, params);
+    err = meanError(right, a);
+    std::cout << "Identity k-NN transfer error: " << err << "\n";
+    assert(err < 0.05f && "Identity k-NN transfer failed");
+    params.knnVote = false;
+
+    // 4: the transfer follows the right frames
+    Image dark(a.rows, a.cols, a.type());
+    for(const Point2i &i : a){
+        dark.at<Vec3f>(i) = a.at<Vec3f>(i) * 0.5f;
+    }
+    rights[0] = dark;
+    rights[1] = dark;
+    lefts[1] = a;
+    params.laplacian = false;
+    right = synthesize(a, lefts, rights, params);
+    err = meanError(right, dark);
+    assert(err < 0.02f && "Right frame transfer failed");
+
+    // 5: the tracked best entries are those of the heaps
+    synth::TargetPatch::width(params.patchSize);
+    ImageSet L(2);
+    L[0] = a;
+    L[1] = b;
+    DistanceFunc d = DistanceFactory<synth::TargetPatch, float, ImageSet>::get(dist::SSD, 3);
+    synth::kNNF knnf(a, L, d);
+    for(const Point2i &i : knnf){
+        knnf.init(i);
+    }
+    auto seq = Algorithm() << Propagation<synth::TargetPatch, float, SYNTH_K>(&knnf);
+    scanline(knnf, 2, seq);
+    for(const Point2i &i : knnf){
+        float best = knnf.distance(i, 0);
+        for(int k = 1; k < SYNTH_K; ++k){
+            best = std::min(best, knnf.distance(i, k));
+        }
+        assert(knnf.top(i).distance == best && "Invalid tracked best entry");
+    }
+
+    // 6: dispatch of k and footprint prediction
+    lefts[0] = rights[0] = a;
+    lefts[1] = rights[1] = b;
+    params.laplacian = true;
+    params.levels = 1;
+    params.k = 3;
+    SynthFootprint usage;
+    right = synthesize(a, lefts, rights, params, &usage);
+    err = meanError(right, a);
+    assert(err < 0.02f && "Identity transfer failed with k=3");
+    SynthFootprint predicted = predictFootprint(params, 3, 2, a.rows, a.cols, 3, double(a.rows) * a.cols, 0, 0, true);
+    assert(usage.nnf == predicted.nnf && "Invalid prediction of the field memory");
+    assert(usage.query == predicted.query && "Invalid prediction of the query memory");
+    assert(std::abs(double(usage.exemplars) - double(predicted.exemplars)) < 0.05 * usage.exemplars
+        && "Invalid prediction of the exemplar memory");
+
+    // 7: planning within a budget
+    const std::vector<int> &values = synthKValues();
+    assert(values.size() >= 3 && std::is_sorted(values.begin(), values.end()) && "Invalid compiled k values");
+    params.targets = 0;
+    params.minTargets = 2;
+    params.budget = 1e9;
+    SynthPlan plan = planSynthesis(params, 10, a.rows, a.cols, 3, double(a.rows) * a.cols);
+    assert(plan.fits && plan.k == values.back() && plan.targets == 10 && "Large budget not used");
+    params.budget = 1.0;
+    plan = planSynthesis(params, 10, a.rows, a.cols, 3, double(a.rows) * a.cols);
+    assert(!plan.fits && plan.k == values.front() && plan.targets == 2 && "Small budget not reported");
+    const SynthFootprint small = predictFootprint(params, values.front(), 3, a.rows, a.cols, 3, double(a.rows) * a.cols);
+    params.budget = small.total();
+    plan = planSynthesis(params, 10, a.rows, a.cols, 3, double(a.rows) * a.cols);
+    assert(plan.fits && plan.footprint.total() <= params.budget && plan.targets >= 2 && "Plan over budget");
+
+    // 8: exemplar pruning with index remapping
+    std::vector<size_t> counts(3);
+    counts[0] = 50; counts[1] = 2; counts[2] = 48;
+    std::vector<int> map = pruneExemplars(counts, 0.1f);
+    assert(map[0] == 0 && map[1] == -1 && map[2] == 1 && "Invalid pruning");
+    ImageSet L3(3);
+    L3[0] = a;
+    L3[1] = b;
+    L3[2] = a;
+    synth::kNNFOf<3> field(a, L3, d);
+    for(const Point2i &i : field){
+        field.init(i);
+    }
+    std::vector<size_t> before = exemplarUsage(field);
+    remapExemplars(field, map);
+    std::vector<size_t> after = exemplarUsage(field);
+    assert(after.size() == 3 && after[0] == before[0] && after[1] == before[2] && after[2] == 0 && "Invalid remapping");
+    for(const Point2i &i : field){
+        for(int k = 0; k < 3; ++k){
+            if(field.data.at(i)[k].patch.index < 0){
+                assert(std::isinf(field.distance(i, k)) && "Dropped entry with a finite distance");
+            }
+        }
+        assert(field.top(i).patch.index >= 0 || std::isinf(field.top(i).distance) && "Invalid best entry after remapping");
+    }
+
+    // 9: pruned and incremental synthesis
+    params.budget = 0.0;
+    params.k = SYNTH_K;
+    params.levels = 2;
+    params.incremental = true;
+    params.pruneThreshold = 0.3f;
+    lefts.push_back(dark);
+    rights.push_back(dark);
+    right = synthesize(a, lefts, rights, params);
+    err = meanError(right, a);
+    std::cout << "Pruned incremental transfer error: " << err << "\n";
+    assert(err < 0.02f && "Pruned incremental transfer failed");
+
+    // 10: the pruned exemplars only get their coarsest level
+    DiskExemplars disk(lefts, rights);
+    SynthFootprint full, pruned;
+    params.incremental = false;
+    params.pruneThreshold = 0.0f;
+    synthesize(a, disk, params, &full);
+    assert(disk.loads == 3 && "Exemplars loaded more than once without pruning");
+    disk.loads = 0;
+    params.pruneThreshold = 0.3f; // may keep all 3 => no lazy pyramids
+    synthesize(a, disk, params);
+    assert(disk.loads == 3 && "Lazy pyramids although all the exemplars could be kept");
+    disk.loads = 0;
+    params.pruneThreshold = 0.4f; // keeps at most 2
+    right = synthesize(a, disk, params, &pruned);
+    assert(meanError(right, a) < 0.02f && "Lazy pruned transfer failed");
+    assert(disk.loads > 3 && disk.loads <= 5 && "The pruned exemplars were loaded again");
+    assert(pruned.exemplars < full.exemplars && "Pruning did not reduce the exemplar memory");
+    predicted = predictFootprint(params, params.k, 3, a.rows, a.cols, 3, double(a.rows) * a.cols);
+    assert(predicted.exemplars >= pruned.exemplars && "Pruned exemplar memory above its prediction");
+    std::cout << "Pruned exemplar memory: " << full.exemplars / 1e6 << " -> " << pruned.exemplars / 1e6 << " MB\n";
+
+    // 11: the k-NN weights are relative to the best entry of each patch
+    Filter filter = synth::voteFilter(params.patchSize, params.voteSigma);
+    synth::KnnVoteOperation<1, SYNTH_K> op(&knnf, &L, &filter, 1e-3f);
+    Image ref = vote(op, 3);
+    for(int k = 0; k < SYNTH_K; ++k){
+        knnf.data.at(0, 0)[k].distance += 1.0f; // outlier patch (1000 sigma2)
+    }
+    Image outlier = vote(op, 3);
+    const Vec3f &v0 = ref.at<Vec3f>(0, 0), &v1 = outlier.at<Vec3f>(0, 0);
+    assert(v0[0] + v0[1] + v0[2] > 0.0f && "Black reference pixel");
+    for(int c = 0; c < 3; ++c){
+        assert(std::abs(v1[c] - v0[c]) < 1e-3f && "Outlier patch vote underflowed");
+    }
+
+    return 0;
+}
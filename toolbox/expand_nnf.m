@@ -0,0 +1,35 @@
+function nnf = expand_nnf( data, K )
+%EXPAND_NNF Expand a compact k-NNF (see src/nnf/compact.h)
+%
+% INPUT
+%   - data        the compact nnf as [rows x cols x 8K] uint8
+%                 (e.g. from load_cache(file, 'nnf', level))
+%   - K           the number of neighbors (default: from the data size)
+%
+% OUTPUT
+%   - nnf         the k-NNF as [rows x cols x 4K] single with [x y z d]
+%                 per neighbor (same layout as ixknnf)
+%
+
+    if nargin < 2
+        K = size(data, 3) / 8;
+    end
+    [rows, cols, ~] = size(data);
+    % bytes first => 4 x uint16 per entry
+    bytes = reshape(permute(data, [3 1 2]), [], 1);
+    words = reshape(typecast(bytes, 'uint16'), [4, K, rows, cols]);
+    dx = double(typecast(reshape(words(1, :, :, :), [], 1), 'int16'));
+    dy = double(typecast(reshape(words(2, :, :, :), [], 1), 'int16'));
+    z = double(reshape(words(3, :, :, :), [], 1));
+    q = double(reshape(words(4, :, :, :), [], 1));
+    % absolute positions
+    [X, Y] = meshgrid(0:cols-1, 0:rows-1);
+    X = reshape(repmat(reshape(X, [1 rows cols]), [K 1 1]), [], 1);
+    Y = reshape(repmat(reshape(Y, [1 rows cols]), [K 1 1]), [], 1);
+    z(z == 65535) = -1;
+    d = 2 .^ ((q - 1) / 1024 - 24);
+    d(q == 0) = 0;
+    d(q == 65535) = Inf;
+    entries = single([X + dx, Y + dy, z, d]');          % [4 x K*rows*cols]
+    nnf = permute(reshape(entries, [4 * K, rows, cols]), [2 3 1]);
+end
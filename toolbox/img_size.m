@@ -0,0 +1,21 @@
+function sz = img_size( file )
+%IMG_SIZE Size [h, w] of an image file without loading its pixels
+%
+% Supports image formats, mat files and cache references (see load_img)
+    if ~isempty(regexp(file, '\.pmc(:\d+)?$', 'once'))
+        [~, planes] = load_cache(file, 'image', 1);
+        tok = regexp(file, ':(\d+)$', 'tokens', 'once');
+        level = 1;
+        if ~isempty(tok)
+            level = str2double(tok{1});
+        end
+        p = planes(strcmp({planes.name}, 'image') & [planes.level] == level);
+        sz = [p.rows, p.cols];
+    elseif length(file) > 4 && strcmp(file(end-3:end), '.mat')
+        info = whos('-file', file);
+        sz = info(1).size(1:2);
+    else
+        info = imfinfo(file);
+        sz = [info.Height, info.Width];
+    end
+end
@@ -0,0 +1,78 @@
+function [ data, planes ] = load_cache( file_name, plane_name, level )
+%LOAD_CACHE Load a plane of a binary cache file (see src/io/cache.h)
+%
+% INPUT
+%   - file_name   the cache file, or a reference 'file.pmc:level'
+%   - plane_name  the plane name (default: 'image')
+%   - level       the pyramid level (default: from the reference, or 1)
+%
+% OUTPUT
+%   - data        the plane as a [rows x cols x channels] array
+%                 (or [rows x cols x bytes] uint8 for custom types)
+%   - planes      the table of contents of the file
+%
+
+    if nargin < 2 || isempty(plane_name)
+        plane_name = 'image';
+    end
+    if nargin < 3
+        [file_name, level] = parse_ref(file_name);
+    end
+
+    fid = fopen(file_name, 'r', 'ieee-le');
+    if fid < 0
+        error('Cannot open cache file %s', file_name);
+    end
+    magic = fread(fid, [1 4], '*char');
+    header = fread(fid, 3, 'uint32');
+    if ~strcmp(magic, 'PMCF') || header(1) ~= 1
+        fclose(fid);
+        error('Invalid cache file %s', file_name);
+    end
+    P = header(2);
+    planes = struct('name', cell(P, 1), 'level', 0, 'rows', 0, 'cols', 0, ...
+                    'type', 0, 'elem_size', 0, 'offset', 0);
+    for p = 1:P
+        name = fread(fid, [1 16], '*char');
+        planes(p).name = name(1:find([name 0] == 0, 1) - 1);
+        v = fread(fid, 6, 'int32');
+        planes(p).level = v(1);
+        planes(p).rows = v(2);
+        planes(p).cols = v(3);
+        planes(p).type = v(4);
+        planes(p).elem_size = v(5);
+        planes(p).offset = fread(fid, 1, 'uint64');
+    end
+
+    idx = find(strcmp({planes.name}, plane_name) & [planes.level] == level, 1);
+    if isempty(idx)
+        fclose(fid);
+        error('No plane %s at level %d in %s', plane_name, level, file_name);
+    end
+    p = planes(idx);
+    % depth and channels of Mat::type()
+    depth = bitand(p.type, 7);
+    channels = bitshift(p.type, -3) + 1;
+    types = {'uint8', 'int8', 'int32', 'single', 'double'};
+    if depth < length(types)
+        precision = ['*' types{depth + 1}];
+    else
+        precision = '*uint8';
+        channels = p.elem_size;
+    end
+    fseek(fid, p.offset, 'bof');
+    data = fread(fid, channels * p.cols * p.rows, precision);
+    fclose(fid);
+    % row-major interleaved channels => matlab layout
+    data = permute(reshape(data, [channels, p.cols, p.rows]), [3 2 1]);
+end
+
+function [file, level] = parse_ref(ref)
+    level = 1;
+    file = ref;
+    tok = regexp(ref, '^(.*):(\d+)$', 'tokens', 'once');
+    if ~isempty(tok)
+        file = tok{1};
+        level = str2double(tok{2});
+    end
+end
@@ -0,0 +1,35 @@
+function [ G, names ] = load_gist_pack( file_name )
+%LOAD_GIST_PACK Load the gists packed by the native gist_pack tool
+%
+% INPUT
+%   - file_name   the packed gist file (see src/io/gistpack.h)
+%
+% OUTPUT
+%   - G           the gist matrix (one row per exemplar, as in pm_select)
+%   - names       the exemplar names (without extension)
+%
+
+    fid = fopen(file_name, 'r', 'ieee-le');
+    if fid < 0
+        error('Cannot open gist pack %s', file_name);
+    end
+    magic = fread(fid, [1 4], '*char');
+    if ~strcmp(magic, 'GSTP')
+        fclose(fid);
+        error('Invalid gist pack %s', file_name);
+    end
+    header = fread(fid, 4, 'uint32');
+    if header(1) ~= 1
+        fclose(fid);
+        error('Unsupported gist pack version %d', header(1));
+    end
+    N = header(2);
+    D = header(3);
+    names = cell(N, 1);
+    for i = 1:N
+        len = fread(fid, 1, 'uint32');
+        names{i} = fread(fid, [1 len], '*char');
+    end
+    G = fread(fid, [D, N], 'single=>double')';
+    fclose(fid);
+end
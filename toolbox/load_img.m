@@ -1,6 +1,8 @@
 function img = load_img(file)
     if ends_with(file, '.mat')
         img = load_mat(file); 
+    elseif ~isempty(regexp(file, '\.pmc(:\d+)?$', 'once'))
+        img = load_cache(file); % binary cache reference 'file.pmc:level'
     else
         img = im2double(imread(file));
     end
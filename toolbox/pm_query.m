@@ -111,6 +111,11 @@ function [knnf, data] = pm_query( query, images, options )
     % k-nnf computation from query to best set
     t = tic;
     start_nnf = get_option(options, 'start_nnf', []);
-    knnf = ixknnf(query, data.left, start_nnf, options);
+    targets = data.left;
+    refs = images(data.group);
+    if ~leftright && all(cellfun(@ischar, refs)) && all(~cellfun(@isempty, regexp(refs, '\.pmc:\d+$', 'once')))
+        targets = refs; % mapped from the binary cache by ixknnf
+    end
+    knnf = ixknnf(query, targets, start_nnf, options);
     fprintf('* k-NNF computed in %f sec.\n', toc(t));
 end
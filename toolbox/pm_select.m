@@ -16,14 +16,34 @@ function group = pm_select( query, images, options )
 
     gist_dir = options.gist_dir;
 
-    % compute the gists if not already computed
+    % packed gists from the native gist_pack tool
     N = length(images);
+    packed = false(N, 1);
+    if isfield(options, 'gist_pack')
+        [pack_G, pack_names] = load_gist_pack(options.gist_pack);
+        for i = 1:N
+            if ischar(images{i})
+                [~, name, ~] = fileparts(images{i});
+                [packed(i), loc] = ismember(name, pack_names);
+                if packed(i)
+                    G(i, :) = pack_G(loc, :);
+                end
+            end
+        end
+    end
+
+    % compute the gists if not already computed
     num_pixels = 0;
-    fprintf('* Loading %d gists ', N); t = tic;
+    fprintf('* Loading %d gists (%d packed) ', N, sum(packed)); t = tic;
     parfor i = 1:N
         img = images{i};
         if ischar(img)
             [~, name, ~] = fileparts(img);
+            if packed(i)
+                sz = img_size(img);
+                num_pixels = num_pixels + sz(2) * floor(sz(1) / 2);
+                continue;
+            end
             gist_file = fullfile(gist_dir, [name '.mat']);
             img = load_img(img);
         else
@@ -59,6 +59,9 @@ function [result, data] = stereo_synth( query, images, varargin )
     if isfield(options, 'cache_dir')
         cache_dir = options.cache_dir;
     end
+    if ~isfield(options, 'gist_pack') && exist(fullfile(cache_dir, 'gist.pack'), 'file')
+        options.gist_pack = fullfile(cache_dir, 'gist.pack'); % from bin/gist_pack
+    end
     if ~exist(cache_dir, 'dir')
         mkdir(cache_dir);
     end
@@ -72,7 +75,7 @@ function [result, data] = stereo_synth( query, images, varargin )
         [~, name, ~] = fileparts(fname);
         % check if not alraedy computed
         pyr_file = get_pyr_file(cache_dir, 1, name, pyr_type);
-        if exist(pyr_file, 'file')
+        if exist(pyr_file, 'file') || exist(get_pyr_cache(cache_dir, name, pyr_type), 'file')
             continue
         end
         img = im2double(imread(fname));
@@ -157,27 +160,53 @@ function [result, data] = stereo_synth( query, images, varargin )
         [knnf, pyr_data] = pm_query(pyr{l}, pyr_images, options);
         fprintf('* Query done in %f sec.\n', toc(t));
         
-        % extract best of knnf
-        t = tic;
-        nnf = ixknnf_top(pyr{l}, pyr_data.left, knnf, options);
-        fprintf('* k-NNF to NNF in %f sec.\n', toc(t));
-        
-        % store pyramid data
-        pyr_data.query = pyr{l};
-        pyr_data.knnf = knnf;
-        pyr_data.nnf = nnf;
+        % right data
         pyr_data.right = get_right_images(...
             cache_dir, l, images(pyr_data.group), pyr_type, pyr_depth ...
         );
         assert(all(size(pyr_data.left{1}) == size(pyr_data.right{1})), ...
             'The left and right data have different sizes');
         
+        % exemplars converted once for both the top and the vote
+        if strcmp(transfer_type, 'patch') && exist('ixdb', 'file') == 3
+            db = ixdb('load', pyr_data.left, pyr_data.right);
+            targets = db;
+        else
+            db = [];
+            targets = pyr_data.left;
+        end
+        
+        % extract best of knnf (unless all the k entries vote)
+        knn_vote = strcmp(transfer_type, 'patch') && get_option(options, 'knn_vote', 0);
+        if knn_vote
+            nnf = [];
+        else
+            t = tic;
+            nnf = ixknnf_top(pyr{l}, targets, knnf, options);
+            fprintf('* k-NNF to NNF in %f sec.\n', toc(t));
+        end
+        
+        % store pyramid data
+        pyr_data.query = pyr{l};
+        pyr_data.knnf = knnf;
+        pyr_data.nnf = nnf;
+        
         %% 3 = transfer
         t = tic;
         left = pyr{l};
         switch transfer_type
             case 'patch'
-                right = ixvote(left, pyr_data.right, nnf, options);
+                if knn_vote
+                    vote_nnf = knnf; % all entries weighted by exp(-(d-dmin)/knn_sigma2)
+                else
+                    vote_nnf = nnf;
+                end
+                if isempty(db)
+                    right = ixvote(left, pyr_data.right, vote_nnf, options);
+                else
+                    right = ixvote(left, db, vote_nnf, options); % right images
+                    ixdb('free', db);
+                end
             case 'diff'
                 diffs = get_diffs(pyr_data.left, pyr_data.right);
                 diff = ixvote(left, diffs, nnf, options);
@@ -224,6 +253,11 @@ function pyr = get_pyramid(img, pyr_type, pyr_depth)
     if nargin < 3 || isempty(pyr_depth)
         pyr_depth = pyr_levels(img);
     end
+    if exist('impyr', 'file') == 3
+        % native version (bin/impyr)
+        pyr = impyr(img, pyr_type, pyr_depth);
+        return
+    end
     G = gaussian_pyr(img, pyr_depth);
     switch pyr_type
         case 'gaussian'
@@ -235,7 +269,7 @@ function pyr = get_pyramid(img, pyr_type, pyr_depth)
     end
 end
 
-function file = get_pyr_file(cache_dir, level, name, pyr_type)
+function pyr_dir = get_pyr_dir(pyr_type)
     switch pyr_type
         case 'gaussian'
             pyr_dir = 'gpyr';
@@ -244,7 +278,15 @@ function file = get_pyr_file(cache_dir, level, name, pyr_type)
         otherwise
             error('Unsupported pyramid type: %s', pyr_type);
     end
-    file = fullfile(cache_dir, pyr_dir, num2str(level), [name '.mat']);
+end
+
+function file = get_pyr_file(cache_dir, level, name, pyr_type)
+    file = fullfile(cache_dir, get_pyr_dir(pyr_type), num2str(level), [name '.mat']);
+end
+
+function file = get_pyr_cache(cache_dir, name, pyr_type)
+    % binary cache with all levels (from bin/pyr_ingest -b)
+    file = fullfile(cache_dir, get_pyr_dir(pyr_type), [name '.pmc']);
 end
 
 function pyr_images = get_pyr_images(cache_dir, level, images, pyr_type)
@@ -252,7 +294,13 @@ function pyr_images = get_pyr_images(cache_dir, level, images, pyr_type)
     pyr_images = cell(1, N);
     for i = 1:N
         [~, name, ~] = fileparts(images{i});
-        pyr_images{i} = get_pyr_file(cache_dir, level, name, pyr_type);
+        pyr_cache = get_pyr_cache(cache_dir, name, pyr_type);
+        if exist(pyr_cache, 'file')
+            % reference to the level, mapped directly by the mex files
+            pyr_images{i} = sprintf('%s:%d', pyr_cache, level);
+        else
+            pyr_images{i} = get_pyr_file(cache_dir, level, name, pyr_type);
+        end
     end
 end
 